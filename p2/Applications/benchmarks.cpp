@@ -0,0 +1,747 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "benchmarks.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "crc32c.h"
+#include "event_loop.h"
+#include "heap_file.h"
+#include "lz_codec.h"
+#include "pax_page.h"
+#include "task_scheduler.h"
+#include "exceptions/file_not_found_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Thread counts every scaling benchmark is run with.
+ */
+const int THREAD_COUNTS[] = {1, 2, 4, 8, 16, 32};
+
+/**
+ * Name of the scratch file the benchmarks run against.
+ */
+const char BENCH_FILE[] = "bench.db";
+
+/**
+ * Number of pages in the scratch file.
+ */
+const PageId BENCH_PAGES = 1024;
+
+/**
+ * Returns the next number of a xorshift sequence, for picking pages at
+ * random without sharing generator state between threads.
+ */
+std::uint32_t nextRandom(std::uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+}
+
+double timeThreads(const int threads, const std::function<void(int)>& body) {
+  std::vector<std::thread> workers;
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; ++t) {
+    workers.push_back(std::thread(body, t));
+  }
+  for (std::size_t t = 0; t < workers.size(); ++t) {
+    workers[t].join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+void benchSlotScan(std::ostream& out) {
+  const int KEEP_EVERY[] = {1, 2, 8, 64, 1024};
+  const int passes = 20000;
+
+  out << "slot scan of a " << Page::DEFAULT_SIZE << "-byte page of 1-byte records\n";
+  out << "kept\tslots\tused\tMslots/s\tMrecords/s\n";
+  for (const int keep_every : KEEP_EVERY) {
+    Page page;
+    std::vector<RecordId> record_ids;
+    while (page.hasSpaceForRecord("x")) {
+      record_ids.push_back(page.insertRecord("x"));
+    }
+    // The last record stays so that the slot array is not shortened.
+    for (std::size_t j = 0; j + 1 < record_ids.size(); ++j) {
+      if (j % keep_every != 0) {
+        page.deleteRecord(record_ids[j]);
+      }
+    }
+
+    // Keeps the scan from being optimized away.
+    std::atomic<std::uint32_t> checksum(0);
+    std::size_t used = 0;
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+      std::uint32_t sum = 0;
+      used = 0;
+      for (SlotId slot = page.getNextUsedSlot(Page::INVALID_SLOT);
+           slot != Page::INVALID_SLOT; slot = page.getNextUsedSlot(slot)) {
+        sum += slot;
+        ++used;
+      }
+      checksum.fetch_add(sum, std::memory_order_relaxed);
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    out << "1/" << keep_every << "\t" << record_ids.size() << "\t" << used
+        << "\t" << passes * record_ids.size() / elapsed.count() / 1e6 << "\t"
+        << passes * used / elapsed.count() / 1e6 << "\n";
+  }
+}
+
+void benchHeapFile(std::ostream& out) {
+  const std::size_t initial_records = 50000;
+  const int ops = 200000;
+  const int scans = 20;
+  // Percent of operations that insert and that erase; the rest are reads.
+  const int MIXES[][2] = {{10, 0}, {50, 0}, {30, 20}};
+
+  try {
+    File::remove(BENCH_FILE);
+  } catch (const FileNotFoundException&) {
+  }
+  {
+    File file = File::create(BENCH_FILE);
+    BufMgr buf_mgr(4096);
+    HeapFile heap(&buf_mgr, &file);
+    std::uint32_t random = 2463534242u;
+    std::string record(150, 'h');
+    // Keeps the reads from being optimized away.
+    std::atomic<std::uint32_t> checksum(0);
+
+    out << "heap file workload (Kops/s)\n";
+    out << "workload\tKops/s\n";
+    std::vector<RecordId> record_ids;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    while (record_ids.size() < initial_records) {
+      record_ids.push_back(
+          heap.insert(record.substr(0, 50 + nextRandom(random) % 101)));
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    out << "load\t" << initial_records / elapsed.count() / 1e3 << "\n";
+
+    for (const int* mix : MIXES) {
+      std::uint32_t sum = 0;
+      start = std::chrono::steady_clock::now();
+      for (int j = 0; j < ops; ++j) {
+        const std::uint32_t pick = nextRandom(random);
+        const std::size_t victim = (pick >> 8) % record_ids.size();
+        if (static_cast<int>(pick % 100) < mix[0]) {
+          record_ids.push_back(
+              heap.insert(record.substr(0, 50 + (pick >> 8) % 101)));
+        } else if (static_cast<int>(pick % 100) < mix[0] + mix[1]) {
+          heap.erase(record_ids[victim]);
+          record_ids[victim] = record_ids.back();
+          record_ids.pop_back();
+        } else {
+          sum += heap.get(record_ids[victim]).length();
+        }
+      }
+      elapsed = std::chrono::steady_clock::now() - start;
+      checksum += sum;
+      out << 100 - mix[0] - mix[1] << "% get/" << mix[0] << "% insert/"
+          << mix[1] << "% erase\t" << ops / elapsed.count() / 1e3 << "\n";
+    }
+
+    std::vector<RecordId> matches;
+    start = std::chrono::steady_clock::now();
+    for (int j = 0; j < scans; ++j) {
+      matches.clear();
+      heap.scan([](const RecordView& view) { return view.length > 100; },
+                matches);
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    checksum += matches.size();
+    out << "scan of " << record_ids.size() << " records\t"
+        << scans * record_ids.size() / elapsed.count() / 1e3 << "\n";
+    buf_mgr.flushFile(&file);
+  }
+  File::remove(BENCH_FILE);
+}
+
+void benchPaxScan(std::ostream& out) {
+  const std::size_t table_bytes = 16 << 20;
+  const int passes = 10;
+  std::vector<std::size_t> widths;
+  widths.push_back(4);
+  widths.push_back(8);
+  widths.push_back(8);
+  widths.push_back(80);
+  const std::size_t record_width = 100;
+
+  // Both tables hold the same records, each starting with its number.
+  std::vector<Page> rows(1);
+  std::vector<Page> columns(1);
+  PaxPage pax(&columns.back(), widths);
+  pax.initialize();
+  std::string record(record_width, 'r');
+  std::size_t records = 0;
+  for (std::uint32_t j = 0; records * record_width < table_bytes; ++j) {
+    std::memcpy(&record[0], &j, sizeof(j));
+    if (!rows.back().hasSpaceForRecord(record)) {
+      rows.push_back(Page());
+    }
+    rows.back().insertRecord(record);
+    if (pax.num_records() == pax.capacity()) {
+      columns.push_back(Page());
+      pax = PaxPage(&columns.back(), widths);
+      pax.initialize();
+    }
+    pax.insertRecord(record);
+    ++records;
+  }
+
+  out << "row vs PAX scan of " << records << " 100-byte records in "
+      << Page::DEFAULT_SIZE << "-byte pages (Mrecords/s)\n";
+  out << "layout\tsum 4-byte column\tcopy records\n";
+  // Keeps the scans from being optimized away.
+  std::atomic<std::uint32_t> checksum(0);
+
+  out << "row";
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (int pass = 0; pass < passes; ++pass) {
+    std::uint32_t sum = 0;
+    for (std::size_t p = 0; p < rows.size(); ++p) {
+      const Page& page = rows[p];
+      for (SlotId slot = page.getNextUsedSlot(Page::INVALID_SLOT);
+           slot != Page::INVALID_SLOT; slot = page.getNextUsedSlot(slot)) {
+        const RecordId record_id = {page.page_number(), slot};
+        std::uint32_t value;
+        std::memcpy(&value, page.getRecordView(record_id).data, sizeof(value));
+        sum += value;
+      }
+    }
+    checksum += sum;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  out << "\t" << passes * records / elapsed.count() / 1e6;
+  start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < passes; ++pass) {
+    std::uint32_t sum = 0;
+    for (std::size_t p = 0; p < rows.size(); ++p) {
+      const Page& page = rows[p];
+      for (SlotId slot = page.getNextUsedSlot(Page::INVALID_SLOT);
+           slot != Page::INVALID_SLOT; slot = page.getNextUsedSlot(slot)) {
+        const RecordId record_id = {page.page_number(), slot};
+        sum += page.getRecord(record_id).length();
+      }
+    }
+    checksum += sum;
+  }
+  elapsed = std::chrono::steady_clock::now() - start;
+  out << "\t" << passes * records / elapsed.count() / 1e6 << "\n";
+
+  out << "PAX";
+  start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < passes; ++pass) {
+    std::uint32_t sum = 0;
+    for (std::size_t p = 0; p < columns.size(); ++p) {
+      const PaxPage page(&columns[p], widths);
+      for (PaxColumnIterator iter = page.columnBegin(0);
+           iter != page.columnEnd(0); ++iter) {
+        std::uint32_t value;
+        std::memcpy(&value, *iter, sizeof(value));
+        sum += value;
+      }
+    }
+    checksum += sum;
+  }
+  elapsed = std::chrono::steady_clock::now() - start;
+  out << "\t" << passes * records / elapsed.count() / 1e6;
+  start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < passes; ++pass) {
+    std::uint32_t sum = 0;
+    for (std::size_t p = 0; p < columns.size(); ++p) {
+      const PaxPage page(&columns[p], widths);
+      for (SlotId slot = page.getNextUsedSlot(Page::INVALID_SLOT);
+           slot != Page::INVALID_SLOT; slot = page.getNextUsedSlot(slot)) {
+        const RecordId record_id = {page.page_number(), slot};
+        sum += page.getRecord(record_id).length();
+      }
+    }
+    checksum += sum;
+  }
+  elapsed = std::chrono::steady_clock::now() - start;
+  out << "\t" << passes * records / elapsed.count() / 1e6 << "\n";
+}
+
+void benchPageSizes(std::ostream& out) {
+  const std::size_t pool_bytes = 4 << 20;
+  const std::size_t file_bytes = 4 * pool_bytes;
+  const std::string record(100, 'r');
+  const int lookups = 200000;
+  // Keeps the reads from being optimized away.
+  std::atomic<std::uint32_t> checksum(0);
+
+  out << "page size trade-off: " << file_bytes / record.length()
+      << " 100-byte records, " << (pool_bytes >> 20) << " MB pool\n";
+  out << "page size\tscan MB/s\tscan hit ratio\tlookups/s\t"
+         "lookup hit ratio\n";
+  for (std::size_t page_size = 4096; page_size <= Page::MAX_SIZE;
+       page_size *= 2) {
+    try {
+      File::remove(BENCH_FILE);
+    } catch (const FileNotFoundException&) {
+    }
+    File file = File::create(BENCH_FILE, false /* compress_pages */,
+                             page_size);
+    BufMgr buf_mgr(pool_bytes / page_size, 1, 1, page_size);
+    std::vector<RecordId> record_ids;
+    std::vector<PageId> pages;
+    {
+      HeapFile heap(&buf_mgr, &file);
+      while (record_ids.size() * record.length() < file_bytes) {
+        record_ids.push_back(heap.insert(record));
+        if (pages.empty() || pages.back() != record_ids.back().page_number) {
+          pages.push_back(record_ids.back().page_number);
+        }
+      }
+    }
+    buf_mgr.flushFile(&file);
+
+    out << page_size;
+    buf_mgr.clearBufStats();
+    std::uint32_t sum = 0;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (std::size_t j = 0; j < pages.size(); ++j) {
+      PageGuard guard = buf_mgr.readPage(&file, pages[j], LATCH_SHARED);
+      for (SlotId slot = guard->getNextUsedSlot(Page::INVALID_SLOT);
+           slot != Page::INVALID_SLOT; slot = guard->getNextUsedSlot(slot)) {
+        const RecordId record_id = {pages[j], slot};
+        sum += guard->getRecordView(record_id).data[0];
+      }
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    BufStats stats = buf_mgr.getBufStats();
+    out << "\t" << file_bytes / elapsed.count() / (1 << 20) << "\t"
+        << 1.0 - static_cast<double>(stats.diskreads) / stats.accesses;
+
+    buf_mgr.clearBufStats();
+    std::uint32_t random = 2463534242u;
+    start = std::chrono::steady_clock::now();
+    for (int j = 0; j < lookups; ++j) {
+      const RecordId& record_id =
+          record_ids[nextRandom(random) % record_ids.size()];
+      PageGuard guard =
+          buf_mgr.readPage(&file, record_id.page_number, LATCH_SHARED);
+      sum += guard->getRecordView(record_id).data[0];
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    stats = buf_mgr.getBufStats();
+    out << "\t" << lookups / elapsed.count() << "\t"
+        << 1.0 - static_cast<double>(stats.diskreads) / stats.accesses
+        << "\n";
+    checksum += sum;
+    buf_mgr.flushFile(&file);
+  }
+  File::remove(BENCH_FILE);
+}
+
+void benchCompression(std::ostream& out) {
+  const PageId pages = 1024;
+  const int passes = 20;
+  // Text records with a varying key, about as compressible as table rows.
+  std::vector<std::string> records;
+  for (std::uint32_t j = 0; records.size() * 100 < Page::DEFAULT_SIZE; ++j) {
+    char record[101];
+    std::snprintf(record, sizeof(record),
+                  "key=%08u name=customer-%05u city=Madison state=WI "
+                  "balance=%07u status=active note=none......",
+                  j * 2654435761u, j % 1000, j * 37 % 100000);
+    records.push_back(std::string(record, 100));
+  }
+
+  out << "page compression: " << pages << " pages of " << Page::DEFAULT_SIZE
+      << " bytes\n";
+  std::string data;
+  for (std::size_t j = 0; j < records.size(); ++j) {
+    data += records[j];
+  }
+  data.resize(Page::DEFAULT_SIZE - sizeof(PageHeader));
+  std::vector<char> compressed(data.size());
+  std::vector<char> restored(data.size());
+  std::size_t compressed_length = 0;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (int pass = 0; pass < passes * static_cast<int>(pages); ++pass) {
+    compressed_length = lzCompress(data.data(), data.size(), &compressed[0],
+                                   compressed.size());
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  out << "codec ratio " << static_cast<double>(data.size()) / compressed_length
+      << ", compress " << passes * pages * data.size() / elapsed.count() /
+                              (1 << 20)
+      << " MB/s";
+  bool intact = true;
+  start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < passes * static_cast<int>(pages); ++pass) {
+    intact &= lzDecompress(&compressed[0], compressed_length, &restored[0],
+                           restored.size());
+  }
+  elapsed = std::chrono::steady_clock::now() - start;
+  out << ", decompress "
+      << passes * pages * data.size() / elapsed.count() / (1 << 20)
+      << " MB/s" << (intact ? "" : " (corrupt)") << "\n";
+
+  out << "file\twrite MB/s\tread MB/s\tfile size KB\ton disk KB\n";
+  // Keeps the reads from being optimized away.
+  std::atomic<std::uint32_t> checksum(0);
+  for (int compress = 0; compress <= 1; ++compress) {
+    try {
+      File::remove(BENCH_FILE);
+    } catch (const FileNotFoundException&) {
+    }
+    const std::size_t bytes = pages * Page::DEFAULT_SIZE;
+    std::vector<PageId> page_numbers;
+    {
+      File file = File::create(BENCH_FILE, compress != 0);
+      start = std::chrono::steady_clock::now();
+      for (PageId j = 0; j < pages; ++j) {
+        Page page = file.allocatePage();
+        for (std::size_t k = j; page.hasSpaceForRecord(
+                                    records[k % records.size()]);
+             ++k) {
+          page.insertRecord(records[k % records.size()]);
+        }
+        file.writePage(page);
+        page_numbers.push_back(page.page_number());
+      }
+      elapsed = std::chrono::steady_clock::now() - start;
+      out << (compress ? "compressed" : "plain") << "\t"
+          << bytes / elapsed.count() / (1 << 20);
+
+      std::uint32_t sum = 0;
+      start = std::chrono::steady_clock::now();
+      for (std::size_t j = 0; j < page_numbers.size(); ++j) {
+        sum += file.readPage(page_numbers[j]).getFreeSpace();
+      }
+      elapsed = std::chrono::steady_clock::now() - start;
+      out << "\t" << bytes / elapsed.count() / (1 << 20);
+      checksum += sum;
+    }
+    struct stat status;
+    if (stat(BENCH_FILE, &status) == 0) {
+      out << "\t" << status.st_size / 1024 << "\t"
+          << status.st_blocks * 512 / 1024 << "\n";
+    } else {
+      out << "\t?\t?\n";
+    }
+  }
+  File::remove(BENCH_FILE);
+}
+
+void benchChecksums(std::ostream& out) {
+  const PageId pages = 1024;
+  const int passes = 20;
+  try {
+    File::remove(BENCH_FILE);
+  } catch (const FileNotFoundException&) {
+  }
+  std::vector<PageId> page_numbers;
+  double write_seconds;
+  double read_seconds;
+  {
+    File file = File::create(BENCH_FILE);
+    std::vector<Page> images;
+    for (PageId j = 0; j < pages; ++j) {
+      images.push_back(file.allocatePage());
+      while (images.back().hasSpaceForRecord(std::string(100, 'r'))) {
+        images.back().insertRecord(std::string(100, 'a' + j % 26));
+      }
+      page_numbers.push_back(images.back().page_number());
+    }
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (std::size_t j = 0; j < images.size(); ++j) {
+      file.writePage(images[j]);
+    }
+    write_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (std::size_t j = 0; j < page_numbers.size(); ++j) {
+      file.readPage(page_numbers[j]);
+    }
+    read_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+  File::remove(BENCH_FILE);
+
+  out << "CRC32C over " << Page::DEFAULT_SIZE << "-byte pages: write "
+      << write_seconds / pages * 1e6 << " us/page, read "
+      << read_seconds / pages * 1e6 << " us/page\n";
+  out << "path\tMB/s\tus/page\t% of write\t% of read\n";
+  const std::string data(Page::DEFAULT_SIZE, 'c');
+  const int paths = crc32cAccelerated() ? 2 : 1;
+  // Keeps the checksums from being optimized away.
+  std::atomic<std::uint32_t> checksum(0);
+  for (int path = 0; path < paths; ++path) {
+    std::uint32_t crc = 0;
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes * static_cast<int>(pages); ++pass) {
+      crc = path == 0 ? crc32cTable(crc, data.data(), data.size())
+                      : crc32c(crc, data.data(), data.size());
+    }
+    const double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count() / passes;
+    checksum += crc;
+    out << (path == 0 ? "table" : "sse4.2") << "\t"
+        << pages * data.size() / seconds / (1 << 20) << "\t"
+        << seconds / pages * 1e6 << "\t"
+        << 100 * seconds / write_seconds << "\t"
+        << 100 * seconds / read_seconds << "\n";
+  }
+}
+
+void benchHotPageLatches(BufMgr* buf_mgr, File* file, const PageId hot,
+                         std::ostream& out) {
+  const int iterations = 200000;
+  // Keeps the page reads from being optimized away.
+  std::atomic<std::uint32_t> checksum(0);
+
+  out << "hot page reads (Mreads/s)\n";
+  out << "threads\tshared\t10% exclusive\toptimistic\n";
+  for (const int threads : THREAD_COUNTS) {
+    out << threads;
+    for (int write_every = 0; write_every <= 10; write_every += 10) {
+      const double seconds = timeThreads(threads, [&](int) {
+        std::uint32_t sink = 0;
+        for (int j = 0; j < iterations; ++j) {
+          const bool write = write_every != 0 && j % write_every == 0;
+          PageGuard guard = buf_mgr->readPage(
+              file, hot, write ? LATCH_EXCLUSIVE : LATCH_SHARED);
+          sink += guard->getFreeSpace();
+          if (write) {
+            guard.markDirty();
+          }
+        }
+        checksum += sink;
+      });
+      out << "\t" << threads * iterations / seconds / 1e6;
+    }
+    const double seconds = timeThreads(threads, [&](int) {
+      std::uint32_t sink = 0;
+      FrameId hint = BufMgr::NO_FRAME;
+      for (int j = 0; j < iterations; ++j) {
+        buf_mgr->readPageOptimistic(file, hot, hint, [&](const Page& page) {
+          sink += page.getFreeSpace();
+        });
+      }
+      checksum += sink;
+    });
+    out << "\t" << threads * iterations / seconds / 1e6 << "\n";
+  }
+}
+
+void benchFaultScaling(File* file, const PageId first, const PageId pages,
+                       const std::uint32_t frames, std::ostream& out) {
+  const int iterations = 20000;
+
+  out << "page faults over " << pages << " pages in " << frames
+      << " frames (Mreads/s)\n";
+  out << "threads\treads\n";
+  for (const int threads : THREAD_COUNTS) {
+    BufMgr buf_mgr(frames);
+    const double seconds = timeThreads(threads, [&](int thread) {
+      std::uint32_t random = 2463534242u + thread;
+      for (int j = 0; j < iterations; ++j) {
+        buf_mgr.readPage(file, first + nextRandom(random) % pages);
+      }
+    });
+    out << threads << "\t" << threads * iterations / seconds / 1e6 << "\n";
+  }
+}
+
+void benchShardScaling(File* file, const PageId first, const PageId pages,
+                       const std::uint32_t frames, std::ostream& out) {
+  const int threads = 16;
+  const int iterations = 20000;
+  const std::uint32_t SHARD_COUNTS[] = {1, 2, 4, 8, 16};
+
+  out << "sharded pool, " << threads << " threads, " << frames
+      << " frames, 80% of reads to 20% of " << pages << " pages\n";
+  out << "shards\tMreads/s\thit ratio\n";
+  for (const std::uint32_t shard_count : SHARD_COUNTS) {
+    BufMgr buf_mgr(frames, shard_count);
+    const double seconds = timeThreads(threads, [&](int thread) {
+      std::uint32_t random = 2463534242u + thread;
+      for (int j = 0; j < iterations; ++j) {
+        const std::uint32_t hot_pages = pages / 5;
+        const PageId page_number =
+            nextRandom(random) % 5 != 0
+                ? nextRandom(random) % hot_pages
+                : hot_pages + nextRandom(random) % (pages - hot_pages);
+        buf_mgr.readPage(file, first + page_number);
+      }
+    });
+    const BufStats& stats = buf_mgr.getBufStats();
+    out << shard_count << "\t" << threads * iterations / seconds / 1e6 << "\t"
+        << 1.0 - static_cast<double>(stats.diskreads) / stats.accesses
+        << "\n";
+  }
+}
+
+void benchParallelScan(File* file, const PageId first, const PageId pages,
+                       const std::uint32_t frames, std::ostream& out) {
+  std::vector<PageId> page_numbers;
+  for (PageId j = 0; j < pages; ++j) {
+    page_numbers.push_back(first + j);
+  }
+  out << "parallel scan of " << pages << " pages\n";
+  out << "workers\tcached Mpages/s\t" << frames << " frames Mpages/s\n";
+  for (const int workers : THREAD_COUNTS) {
+    double rates[2];
+    for (int cold = 0; cold < 2; ++cold) {
+      BufMgr buf_mgr(cold ? frames : pages);
+      TaskScheduler scheduler(workers);
+      // Keeps the record reads from being optimized away.
+      std::atomic<std::uint32_t> checksum(0);
+      const auto visit = [&checksum](PageId, const Page& page) {
+        std::uint32_t crc = 0;
+        for (SlotId slot = page.getNextUsedSlot(Page::INVALID_SLOT);
+             slot != Page::INVALID_SLOT; slot = page.getNextUsedSlot(slot)) {
+          const RecordId record_id = {page.page_number(), slot};
+          const RecordView record = page.getRecordView(record_id);
+          crc = crc32c(crc, record.data, record.length);
+        }
+        checksum.fetch_xor(crc, std::memory_order_relaxed);
+      };
+      if (!cold) {
+        scanPages(scheduler, &buf_mgr, file, page_numbers, visit);
+      }
+      const int passes = cold ? 1 : 10;
+      const auto start = std::chrono::steady_clock::now();
+      for (int pass = 0; pass < passes; ++pass) {
+        scanPages(scheduler, &buf_mgr, file, page_numbers, visit);
+      }
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      rates[cold] = passes * pages / elapsed.count() / 1e6;
+    }
+    out << workers << "\t" << rates[0] << "\t" << rates[1] << "\n";
+  }
+}
+
+void benchAsyncLookups(File* file, const PageId first, const PageId pages,
+                       const std::uint32_t frames, std::ostream& out) {
+  const int lookups = 20000;
+  const int IN_FLIGHT[] = {1, 4, 16, 64, 128};
+
+  out << "async point lookups on one thread, " << frames << " frames, "
+      << pages << " pages\n";
+  out << "in flight\tKlookups/s\thit ratio\n";
+  for (const int in_flight : IN_FLIGHT) {
+    BufMgr buf_mgr(frames);
+    TaskScheduler io(8);
+    EventLoop loop(io);
+    std::uint32_t random = 2463534242u;
+    int issued = 0;
+    // Keeps the page reads from being optimized away.
+    std::atomic<std::uint32_t> checksum(0);
+    // Each completed lookup issues the next one, so <in_flight> chains of
+    // lookups run interleaved on the loop.
+    std::function<void()> lookup = [&]() {
+      if (issued == lookups) {
+        return;
+      }
+      ++issued;
+      readPageAsync(loop, &buf_mgr, file,
+                    first + nextRandom(random) % pages, LATCH_SHARED,
+                    [&](PageGuard page, std::exception_ptr error) {
+                      if (error) {
+                        std::rethrow_exception(error);
+                      }
+                      checksum += page->getFreeSpace();
+                      page.release();
+                      lookup();
+                    });
+    };
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (int j = 0; j < in_flight; ++j) {
+      lookup();
+    }
+    loop.run();
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    const BufStats& stats = buf_mgr.getBufStats();
+    out << in_flight << "\t" << lookups / elapsed.count() / 1e3 << "\t"
+        << 1.0 - static_cast<double>(stats.diskreads) / stats.accesses
+        << "\n";
+  }
+}
+
+void runBenchmarks(std::ostream& out) {
+  try {
+    File::remove(BENCH_FILE);
+  } catch (const FileNotFoundException&) {
+  }
+  benchSlotScan(out);
+  benchHeapFile(out);
+  benchPaxScan(out);
+  benchPageSizes(out);
+  benchCompression(out);
+  benchChecksums(out);
+  {
+    File file = File::create(BENCH_FILE);
+    BufMgr buf_mgr(64);
+    PageId hot;
+    {
+      PageGuard guard = buf_mgr.allocPage(&file, hot);
+      guard->insertRecord("hot");
+      guard.markDirty();
+    }
+
+    PageId first = hot + 1;
+    for (PageId j = 1; j < BENCH_PAGES; ++j) {
+      PageId page_number;
+      PageGuard guard = buf_mgr.allocPage(&file, page_number);
+      while (guard->hasSpaceForRecord(std::string(200, 'r'))) {
+        guard->insertRecord(std::string(200, 'a' + page_number % 26));
+      }
+      guard.markDirty();
+    }
+
+    benchHotPageLatches(&buf_mgr, &file, hot, out);
+
+    buf_mgr.flushFile(&file);
+    benchFaultScaling(&file, first, BENCH_PAGES - 1, 64, out);
+    benchShardScaling(&file, first, BENCH_PAGES - 1, 256, out);
+    benchParallelScan(&file, first, BENCH_PAGES - 1, 64, out);
+    benchAsyncLookups(&file, first, BENCH_PAGES - 1, 256, out);
+  }
+  File::remove(BENCH_FILE);
+}
+
+}
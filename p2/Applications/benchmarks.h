@@ -0,0 +1,173 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <functional>
+#include <iostream>
+
+#include "buffer.h"
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * Runs <body> on <threads> threads at once, passing each its thread number,
+ * and returns the wall-clock seconds until the last one finished.
+ *
+ * @param threads  Number of threads to start.
+ * @param body     Work done by each thread.
+ * @return  Elapsed seconds.
+ */
+double timeThreads(const int threads, const std::function<void(int)>& body);
+
+/**
+ * Measures how fast the used slots of a page are enumerated with
+ * Page::getNextUsedSlot() as the page goes from dense to sparse: a page is
+ * filled with one-byte records and all but every k-th is deleted, so the
+ * slot array keeps its length while fewer of its slots are used.
+ *
+ * @param out  Stream the results are printed to.
+ */
+void benchSlotScan(std::ostream& out);
+
+/**
+ * Measures HeapFile throughput on records of 50 to 150 bytes through a pool
+ * that holds the whole file: loading the file with inserts, mixes of point
+ * reads with inserts and erases, and full scans with a predicate.
+ *
+ * @param out  Stream the results are printed to.
+ */
+void benchHeapFile(std::ostream& out);
+
+/**
+ * Measures how fast one column of a table of 100-byte records (columns of
+ * 4, 8, 8 and 80 bytes) is summed when the pages use the row (slotted)
+ * layout and when they use the PAX layout, and how fast whole records are
+ * copied out of each.  The pages are held in memory, so only the layouts'
+ * use of the CPU caches is compared.
+ *
+ * @param out  Stream the results are printed to.
+ */
+void benchPaxScan(std::ostream& out);
+
+/**
+ * Measures, for each supported page size from 4 KB up, how fast a file of
+ * 100-byte records is scanned and how many random point lookups per second
+ * it serves, through a buffer pool of the same number of bytes whatever the
+ * page size.  The file is four times the size of the pool, so most reads
+ * miss: large pages amortize each read over more records in a scan, small
+ * pages read less that is not needed in a lookup.
+ *
+ * @param out  Stream the results are printed to.
+ */
+void benchPageSizes(std::ostream& out);
+
+/**
+ * Measures the page compression of File::create(): how fast the codec
+ * compresses and decompresses pages of 100-byte text records, and, for a
+ * plain and a compressed file of the same pages, how fast they are written
+ * and read back and how many bytes they take on disk.  The disk footprint of
+ * the compressed file only shrinks where the filesystem supports hole
+ * punching.
+ *
+ * @param out  Stream the results are printed to.
+ */
+void benchCompression(std::ostream& out);
+
+/**
+ * Measures what the page checksums cost: how fast CRC32C runs over a full
+ * page with the SSE4.2 instruction (where the CPU has it) and with the table
+ * driven fallback, against the time File takes to write and read a page of
+ * the same size through the operating system's cache, which includes
+ * the checksum crc32c() computes.
+ *
+ * @param out  Stream the results are printed to.
+ */
+void benchChecksums(std::ostream& out);
+
+/**
+ * Measures read throughput on a single hot page as threads are added: under
+ * shared latches, under shared latches with one access in ten exclusive, and
+ * with optimistic reads that take neither pin nor latch.
+ *
+ * @param buf_mgr  Buffer manager to pin the page through.
+ * @param file     File holding the page.
+ * @param hot      Number of the page every thread pins.
+ * @param out      Stream the results are printed to.
+ */
+void benchHotPageLatches(BufMgr* buf_mgr, File* file, const PageId hot,
+                         std::ostream& out);
+
+/**
+ * Measures how many pages per second threads can read when nearly every read
+ * misses, so that throughput is bounded by victim selection and eviction,
+ * as threads are added.  Each thread count gets a new buffer manager.
+ *
+ * @param file    File holding the pages.
+ * @param first   Number of the first page read.
+ * @param pages   Number of consecutive pages read, at random.
+ * @param frames  Number of frames in the buffer pool.
+ * @param out     Stream the results are printed to.
+ */
+void benchFaultScaling(File* file, const PageId first, const PageId pages,
+                       const std::uint32_t frames, std::ostream& out);
+
+/**
+ * Measures read throughput and hit ratio of a skewed random workload on 16
+ * threads as the buffer pool is split into more shards.  Each shard count
+ * gets a new buffer manager.
+ *
+ * @param file    File holding the pages.
+ * @param first   Number of the first page read.
+ * @param pages   Number of consecutive pages read.
+ * @param frames  Number of frames in the buffer pool.
+ * @param out     Stream the results are printed to.
+ */
+void benchShardScaling(File* file, const PageId first, const PageId pages,
+                       const std::uint32_t frames, std::ostream& out);
+
+/**
+ * Measures how fast a TaskScheduler scans a file, checksumming every record,
+ * as workers are added: with the whole file cached, and through a pool of
+ * <frames> frames so that most pages are faulted in.  Each run gets a new
+ * buffer manager and scheduler.
+ *
+ * @param file    File holding the pages.
+ * @param first   Number of the first page scanned.
+ * @param pages   Number of consecutive pages scanned.
+ * @param frames  Number of frames in the buffer pool of the faulting scans.
+ * @param out     Stream the results are printed to.
+ */
+void benchParallelScan(File* file, const PageId first, const PageId pages,
+                       const std::uint32_t frames, std::ostream& out);
+
+/**
+ * Measures point lookups per second driven by a single thread through an
+ * EventLoop, as more lookups are kept in flight at once.  Pages are read at
+ * random through a pool of <frames> frames, so most lookups miss and are
+ * read in by the loop's I/O workers.  Every lookup in flight may hold a pin,
+ * so at most 128 are kept in flight and <frames> must be larger.
+ *
+ * @param file    File holding the pages.
+ * @param first   Number of the first page read.
+ * @param pages   Number of consecutive pages read.
+ * @param frames  Number of frames in the buffer pool.
+ * @param out     Stream the results are printed to.
+ */
+void benchAsyncLookups(File* file, const PageId first, const PageId pages,
+                       const std::uint32_t frames, std::ostream& out);
+
+/**
+ * Runs every benchmark against a scratch file and prints the results.
+ * Invoked by running the test binary with the argument "bench".
+ *
+ * @param out  Stream the results are printed to.
+ */
+void runBenchmarks(std::ostream& out);
+
+}
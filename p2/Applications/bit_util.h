@@ -0,0 +1,82 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * Returns the index of the lowest set bit in the given word.
+ *
+ * @param bits  Word to search; must be non-zero.
+ * @return  Index of the lowest set bit.
+ */
+inline std::size_t countTrailingZeros(const std::uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(bits);
+#else
+  std::size_t n = 0;
+  while (((bits >> n) & 1) == 0) {
+    ++n;
+  }
+  return n;
+#endif
+}
+
+/**
+ * Returns the number of the first set bit at or after <start> in a bitmap of
+ * <num_bits> bits, or <num_bits> if there is none.  Bits at and above
+ * <num_bits> are ignored.
+ *
+ * @param words     Bitmap words; bit i lives in words[i / 64].
+ * @param num_bits  Number of meaningful bits in the bitmap.
+ * @param start     First bit to consider.
+ * @return  Number of the first set bit at or after start, or num_bits.
+ */
+inline std::size_t findNextSetBit(const std::uint64_t* words,
+                                  const std::size_t num_bits,
+                                  const std::size_t start) {
+  if (start >= num_bits) {
+    return num_bits;
+  }
+  const std::size_t last_word = (num_bits - 1) / 64;
+  std::size_t word = start / 64;
+  std::uint64_t bits = words[word] & (~std::uint64_t(0) << (start % 64));
+  while (bits == 0) {
+    if (++word > last_word) {
+      return num_bits;
+    }
+    bits = words[word];
+  }
+  const std::size_t bit = word * 64 + countTrailingZeros(bits);
+  return bit < num_bits ? bit : num_bits;
+}
+
+/**
+ * Returns the number of the first clear bit in a bitmap of <num_bits> bits,
+ * or <num_bits> if every bit is set.
+ *
+ * @param words     Bitmap words; bit i lives in words[i / 64].
+ * @param num_bits  Number of meaningful bits in the bitmap.
+ * @return  Number of the first clear bit, or num_bits.
+ */
+inline std::size_t findFirstClearBit(const std::uint64_t* words,
+                                     const std::size_t num_bits) {
+  for (std::size_t word = 0; word * 64 < num_bits; ++word) {
+    const std::uint64_t clear = ~words[word];
+    if (clear != 0) {
+      const std::size_t bit = word * 64 + countTrailingZeros(clear);
+      return bit < num_bits ? bit : num_bits;
+    }
+  }
+  return num_bits;
+}
+
+}
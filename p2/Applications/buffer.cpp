@@ -7,14 +7,22 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
+#include <cassert>
+#include <functional>
 #include <memory>
 #include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
 #include "buffer.h"
+#include "numa.h"
 #include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/bad_buffer_exception.h"
 #include "exceptions/hash_not_found_exception.h"
+#include "exceptions/invalid_page_size_exception.h"
 
 namespace badgerdb { 
 
@@ -25,11 +33,15 @@ namespace badgerdb {
 /*
  *The class constructor. Allocates an array for the buffer pool with bufs page frames
  *and a corresponding BufDesc table. The way things are set up all frames will be in the
- *clear state when the buffer pool is allocated. The hash table will also start out in an empty
- *state.
+ *clear state when the buffer pool is allocated. The frames are divided as evenly as possible
+ *between the shards, each of whose hash tables will also start out in an empty state, and
+ *each shard's frames between the NUMA partitions. Every frame is sized for pages of frameSize bytes,
+ *and pages are read (File::readPage(PageId, Page&)) or copied into the frame's existing storage, so a page of
+ *any size up to frameSize never reallocates the frame's memory.
  */
-BufMgr::BufMgr(std::uint32_t bufs)
-	: numBufs(bufs) {
+BufMgr::BufMgr(std::uint32_t bufs, std::uint32_t shardCount, std::uint32_t numaNodes, std::size_t frameSize)
+	: numBufs(bufs), frameSize(frameSize) {
+	assert(Page::isValidSize(frameSize));
 	bufDescTable = new BufDesc[bufs];
 
   for (FrameId i = 0; i < bufs; i++) 
@@ -38,12 +50,57 @@ BufMgr::BufMgr(std::uint32_t bufs)
   	bufDescTable[i].valid = false;
   }
 
-  bufPool = new Page[bufs];
+  numShards = std::max(1u, std::min(shardCount, bufs));
+  numNodes = numaNodes == 0 ? numaNodeCount() : numaNodes;
+  shards = new BufShard[numShards];
+  partitions = new FramePartition[numShards * numNodes];
+  FrameId first = 0;
+  for (std::uint32_t i = 0; i < numShards; i++)
+  {
+    BufShard& shard = shards[i];
+    shard.firstFrame = first;
+    shard.numFrames = bufs / numShards + (i < bufs % numShards ? 1 : 0);
+    first += shard.numFrames;
+
+    int htsize = ((((int) (shard.numFrames * 1.2))*2)/2)+1;
+    shard.hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
+
+    shard.partitions = &partitions[i * numNodes];
+    for (std::uint32_t n = 0; n < numNodes; n++)
+    {
+      FramePartition& partition = shard.partitions[n];
+      partition.firstFrame = shard.firstFrame + shard.numFrames * n / numNodes;
+      partition.numFrames = shard.firstFrame + shard.numFrames * (n + 1) / numNodes - partition.firstFrame;
+      for (FrameId f = partition.firstFrame; f < partition.firstFrame + partition.numFrames; f++)
+        bufDescTable[f].numaNode = n;
 
-  int htsize = ((((int) (bufs * 1.2))*2)/2)+1;
-  hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
+	  //every frame starts out free, listed so that the lowest is handed out first
+      partition.freeFrames.reserve(partition.numFrames);
+      for (FrameId f = partition.firstFrame + partition.numFrames; f > partition.firstFrame; f--)
+        partition.freeFrames.push_back(f - 1);
+      partition.freeCount = partition.numFrames;
+    }
+  }
 
-  clockHand = bufs - 1;
+  bufPool = static_cast<Page*>(::operator new(sizeof(Page) * bufs));
+  if (numNodes == 1)
+  {
+    constructFrames(0);
+  }
+  else
+  {
+	//first touch each partition's pages from a thread running on its node
+    std::vector<std::thread> builders;
+    for (std::uint32_t n = 0; n < numNodes; n++)
+    {
+      builders.push_back(std::thread([this, n]() {
+        runOnNumaNode(n % numaNodeCount());
+        constructFrames(n);
+      }));
+    }
+    for (std::size_t n = 0; n < builders.size(); n++)
+      builders[n].join();
+  }
 }
 
 /*
@@ -55,71 +112,325 @@ BufMgr::BufMgr(std::uint32_t bufs)
         for (std::uint32_t i = 0; i < numBufs; i++)
         {
 		//condition for page to be dirty 
-            if (bufDescTable[i].dirty && File::isOpen(bufDescTable[i].file->filename())) {
+            if (bufDescTable[i].isDirty() && File::isOpen(bufDescTable[i].file.load()->filename())) {
 		    //flushes dirty pages adn writes to disk
-				bufDescTable[i].file->writePage(bufPool[i]);
-				bufDescTable[i].dirty = false;
-				bufStats.diskwrites++;
+				bufDescTable[i].file.load()->writePage(bufPool[i]);
+				bufDescTable[i].markClean();
+				shardOf(bufDescTable[i].file, bufDescTable[i].pageNo).stats.diskwrites++;
             }
         }
-	//deallocates the buffer pool and the BufDesc table
-        delete [] bufPool;
+	//deallocates the buffer pool, the BufDesc table and the shards' hash tables
+        for (std::uint32_t i = 0; i < numShards; i++)
+        {
+            delete shards[i].hashTable;
+        }
+        delete [] shards;
+        delete [] partitions;
+        for (std::uint32_t i = 0; i < numBufs; i++)
+        {
+            bufPool[i].~Page();
+        }
+        ::operator delete(bufPool);
         delete [] bufDescTable;
 		bufDescTable = NULL;
 		bufPool = NULL;
     }
 
 /*
-* advances the clock
-* @author: Pratyusha Emkay (pemkay@wisc.edu)
-*/
-    void BufMgr::advanceClock() {
-       clockHand = (clockHand + 1) % numBufs;
+ * Picks a shard by mixing the file pointer and page number, so that consecutive pages of a file
+ * are spread across the shards rather than landing in neighbouring buckets.
+ */
+    BufShard& BufMgr::shardOf(const File* file, const PageId pageNo) {
+        std::uint64_t key = reinterpret_cast<std::uintptr_t>(file) ^ (static_cast<std::uint64_t>(pageNo) << 32 | pageNo);
+        key *= 0x9e3779b97f4a7c15ull;
+        return shards[(key >> 32) % numShards];
     }
 
 /*
- * Allocates a free frame using the clock algorithm; if necessary, writing a dirty page back
- * to disk  
- * Gets called by the readPage() and allocPage() methods
+ * Picks the I/O lock by file name rather than File pointer, since copies of a File share its stream.
+ */
+    std::mutex& BufMgr::ioMutexOf(const File* file) {
+        return ioMutexes[std::hash<std::string>()(file->filename()) % IO_LOCKS];
+    }
+
+    BufStats & BufMgr::getBufStats() {
+        bufStats.clear();
+        for (std::uint32_t i = 0; i < numShards; i++)
+        {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            bufStats.accesses += shards[i].stats.accesses;
+            bufStats.diskreads += shards[i].stats.diskreads;
+            bufStats.diskwrites += shards[i].stats.diskwrites;
+            bufStats.localhits += shards[i].stats.localhits;
+            bufStats.remotehits += shards[i].stats.remotehits;
+        }
+        return bufStats;
+    }
+
+    std::uint32_t BufMgr::currentNode() const {
+        return numNodes == 1 ? 0 : currentNumaNode() % numNodes;
+    }
+
+    void BufMgr::constructFrames(const std::uint32_t node) {
+        for (FrameId i = 0; i < numBufs; i++) {
+            if (bufDescTable[i].numaNode == node) {
+                new (&bufPool[i]) Page(frameSize);
+            }
+        }
+    }
+
+    void BufMgr::clearBufStats() {
+        for (std::uint32_t i = 0; i < numShards; i++)
+        {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            shards[i].stats.clear();
+        }
+        bufStats.clear();
+    }
+
+namespace {
+
+/**
+ * Frames of a clock a thread has taken but not yet examined
+ */
+struct ClockBatch
+{
+  const void* clock;
+  std::uint64_t next;
+  std::uint64_t end;
+};
+
+/**
+ * Number of clocks a thread keeps a batch for at once
+ */
+const std::size_t CLOCK_BATCHES = 16;
+
+/**
+ * Batches of the clocks this thread has swept recently, indexed by the clock's partition.  A clock
+ * that shares a slot with another one starts a new batch whenever the thread switches between them.
+ */
+thread_local ClockBatch clockBatches[CLOCK_BATCHES];
+
+/**
+ * Number of free frames a thread caches per partition; half of them move to or from the partition's list at a time
+ */
+const std::uint32_t FREE_CACHE = 16;
+
+/**
+ * Free frames of a partition cached by a thread
+ */
+struct FreeCache
+{
+  const void* partition;
+  std::uint32_t count;
+  FrameId frames[FREE_CACHE];
+};
+
+/**
+ * Free-frame caches of this thread, indexed like its clock batches.  The cached frames are not
+ * claimed, so frames left behind by an exited thread or a dropped cache are still found by the clock.
+ */
+thread_local FreeCache freeCaches[CLOCK_BATCHES];
+
+/**
+ * Returns this thread's free-frame cache for the partition at the given index, emptying it first if
+ * it was last used for another partition.
+ */
+FreeCache& freeCacheOf(const FramePartition& partition, const std::ptrdiff_t index)
+{
+  FreeCache& cache = freeCaches[index % CLOCK_BATCHES];
+  if (cache.partition != &partition)
+  {
+    cache.partition = &partition;
+    cache.count = 0;
+  }
+  return cache;
+}
+
+}
+
+/*
+ * Claims a victim frame in the shard, trying the partition on the calling thread's NUMA node
+ * first and then the others in turn.
+ *
+ * @param shard   	Shard to take the frame from
+ * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+ * @throws BufferExceededException If all buffer frames of the shard are pinned
+ */
+    void BufMgr::allocBuf(BufShard & shard, FrameId & frame) {
+        const std::uint32_t home = currentNode();
+        for (std::uint32_t n = 0; n < numNodes; n++) {
+            FramePartition& partition = shard.partitions[(home + n) % numNodes];
+            if (partition.numFrames > 0 && (takeFreeFrame(partition, frame) || allocBuf(partition, frame))) {
+                return;
+            }
+        }
+	//all frames are pinned
+        throw BufferExceededException();
+    }
+
+/*
+ * Claims a victim frame in the partition using the clock algorithm. Threads advance the shared
+ * clock hand by CLOCK_BATCH frames at a time and sweep their batch on their own, continuing where
+ * they left off on the next call, so concurrent faults do not serialize on the hand and a single
+ * thread sweeps the frames in order. A frame is tested and claimed with one compare-and-swap on its
+ * state word, which fails if the frame was pinned or referenced in between.
+ * Gets called by the readPage() and allocPage() methods, without holding the shard's lock
  *
+ * @param partition	Partition to take the frame from
  * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
- * @throws BufferExceededException If all buffer frames are pinned
+ * @return  False if all frames of the partition are pinned
  */
-    void BufMgr::allocBuf(FrameId & frame) {
+    bool BufMgr::allocBuf(FramePartition & partition, FrameId & frame) {
 	//initialize variables
         std::uint32_t pinCount = 0;
-	//loops through all the frames. And condition for clock algorithm to stop
-        while(pinCount <= numBufs){
-            advanceClock();
-	    //does not contain a valid page
-            if (bufDescTable[clockHand].valid == false){
-                frame = bufDescTable[clockHand].frameNo;
-                return;
-		//resets refbit if true and goes to next loop
-            }if(bufDescTable[clockHand].refbit){
-                bufDescTable[clockHand].refbit = false;
+        ClockBatch& batch = clockBatches[(&partition - partitions) % CLOCK_BATCHES];
+        if(batch.clock != &partition.clockHand){
+            batch.clock = &partition.clockHand;
+            batch.next = batch.end = 0;
+        }
+	//loops through the partition's frames. And condition for clock algorithm to stop
+        while(pinCount <= partition.numFrames){
+            if(batch.next == batch.end){
+                batch.next = partition.clockHand.fetch_add(CLOCK_BATCH, std::memory_order_relaxed);
+                batch.end = batch.next + CLOCK_BATCH;
+            }
+            BufDesc& desc = bufDescTable[partition.firstFrame + batch.next++ % partition.numFrames];
+            std::uint32_t state = desc.state.load();
+		//resets refbit if true and goes to next frame
+            if((state & BufDesc::REFBIT) != 0){
+                desc.state.compare_exchange_strong(state, state & ~BufDesc::REFBIT);
                 continue;
-		//checks if current frame is pinned, if yes skip, else update pin Count 
-            }if(bufDescTable[clockHand].pinCnt == 0){
-                break;
-            }else{
+            }
+		//checks if current frame is pinned or being evicted by another thread, if yes skip
+            if((state & (BufDesc::PIN_MASK | BufDesc::CLAIMED)) != 0){
                 pinCount++;
+                continue;
+            }
+		//unpinned and not referenced; invalid frames always end up here
+            if(desc.state.compare_exchange_strong(state, BufDesc::CLAIMED)){
+                frame = desc.frameNo;
+                return true;
             }
         }
-	//all frames are pinned
-        if(pinCount > numBufs){
-            throw BufferExceededException();
+        return false;
+    }
+
+/*
+ * Claims a free frame of the partition. Cached frames are popped off the end of the thread's cache,
+ * and when it is empty up to half a cache is taken from the partition's free list under its lock.
+ * A frame is claimed only if it is still unpinned, unreferenced and unclaimed; a frame the clock gave
+ * to a page since it was freed is skipped, and one that has been emptied again is as good as any other.
+ *
+ * @param partition	Partition to take the frame from
+ * @param frame   	Frame reference, frame ID of claimed frame returned via this variable
+ * @return  False if there is no free frame
+ */
+    bool BufMgr::takeFreeFrame(FramePartition & partition, FrameId & frame) {
+        FreeCache& cache = freeCacheOf(partition, &partition - partitions);
+        for (;;) {
+            if (cache.count == 0) {
+                if (partition.freeCount.load(std::memory_order_relaxed) == 0) {
+                    return false;
+                }
+                std::lock_guard<std::mutex> lock(partition.freeMutex);
+                const std::uint32_t n = std::min<std::size_t>(FREE_CACHE / 2, partition.freeFrames.size());
+		//lowest frames first, as the clock would hand them out
+                for (std::uint32_t k = 0; k < n; k++) {
+                    cache.frames[n - 1 - k] = partition.freeFrames.back();
+                    partition.freeFrames.pop_back();
+                }
+                cache.count = n;
+                partition.freeCount.store(partition.freeFrames.size(), std::memory_order_relaxed);
+                if (n == 0) {
+                    return false;
+                }
+            }
+            frame = cache.frames[--cache.count];
+            if (frame < partition.firstFrame || frame >= partition.firstFrame + partition.numFrames) {
+                continue;
+            }
+            std::uint32_t state = 0;
+            if (bufDescTable[frame].state.compare_exchange_strong(state, BufDesc::CLAIMED)) {
+                return true;
+            }
         }
+    }
+
+/*
+ * Caches a frame that was just cleared for the calling thread's next allocation. When the cache is
+ * full its older half goes to the partition's free list, which never holds more entries than the
+ * partition has frames; hints dropped then are left to the clock.
+ *
+ * @param shard   	Shard holding the frame
+ * @param frame   	Cleared frame
+ */
+    void BufMgr::freeFrame(BufShard & shard, const FrameId frame) {
+        FramePartition& partition = shard.partitions[bufDescTable[frame].numaNode];
+        FreeCache& cache = freeCacheOf(partition, &partition - partitions);
+        if (cache.count == FREE_CACHE) {
+            std::lock_guard<std::mutex> lock(partition.freeMutex);
+            for (std::uint32_t k = 0; k < FREE_CACHE / 2; k++) {
+                if (partition.freeFrames.size() < partition.numFrames) {
+                    partition.freeFrames.push_back(cache.frames[k]);
+                }
+                cache.frames[k] = cache.frames[k + FREE_CACHE / 2];
+            }
+            cache.count = FREE_CACHE / 2;
+            partition.freeCount.store(partition.freeFrames.size(), std::memory_order_relaxed);
+        }
+        cache.frames[cache.count++] = frame;
+    }
+
+/*
+ * Empties a frame claimed by allocBuf(): flushes the page to disk if it is dirty, removes it from
+ * the hashtable and clears the frame. Returns false, dropping the claim, if the frame was pinned
+ * after it was claimed. Called holding the shard's lock.
+ */
+    bool BufMgr::evictClaimed(BufShard & shard, FrameId frame) {
+        BufDesc& desc = bufDescTable[frame];
+        if(desc.pinCnt() > 0){
+            releaseClaim(frame);
+            return false;
+        }
+	//frames cleared by flushFile() or disposePage() since they were claimed hold no page
+        if(desc.valid){
 	//flushes page to disk if it is dirty
-        if(bufDescTable[clockHand].dirty){
-            bufDescTable[clockHand].file->writePage(bufPool[clockHand]);
-            frame = bufDescTable[clockHand].frameNo;
-        }else{
-            frame = bufDescTable[clockHand].frameNo;
+            if(desc.isDirty()){
+                File* file = desc.file;
+                std::lock_guard<std::mutex> io(ioMutexOf(file));
+                file->writePage(bufPool[frame]);
+                shard.stats.diskwrites++;
+            }
+            shard.hashTable->remove(desc.file, desc.pageNo);
         }
-	//contains a valid pages and deletes it from hashtable
-        hashTable->remove(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo);
-        bufDescTable[clockHand].Clear();
+	//optimistic readers of the old page will retry from here on
+        desc.beginWrite();
+        desc.Clear();
+        return true;
+    }
+
+    void BufMgr::releaseClaim(FrameId frame) {
+        bufDescTable[frame].state.fetch_and(~BufDesc::CLAIMED);
+    }
+
+/*
+ * Looks (file, pageNo) up in the hashtable and, if it is there, sets the refbit and increments the
+ * pin count of its frame, counting a local or remote hit. Called holding the shard's lock.
+ */
+    bool BufMgr::pinIfPresent(BufShard & shard, File* file, const PageId pageNo, FrameId & frame) {
+        try {
+            shard.hashTable->lookup(file, pageNo, frame);
+        } catch (const HashNotFoundException&) {
+            return false;
+        }
+        bufDescTable[frame].pin();
+        if (bufDescTable[frame].numaNode == currentNode()) {
+            shard.stats.localhits++;
+        } else {
+            shard.stats.remotehits++;
+        }
+        return true;
     }
 
 /**
@@ -143,30 +454,151 @@ BufMgr::BufMgr(std::uint32_t bufs)
  * @throws BufferExceededException if all buffer frames are pinned
  */
     void BufMgr::readPage(File* file, const PageId pageNo, Page*& page) {
+	//Return a pointer to the frame containing the page via the page parameter
+        page = &bufPool[pinFrame(file, pageNo)];
+    }
+
+/**
+ * Reads the given page from the file into a frame and returns a guard holding the pin.
+ *
+ * @param file   	File object
+ * @param PageNo  Page number in the file to be read
+ * @param mode  	Mode in which to latch the frame
+ * @return  Guard pinning the frame holding the page
+ * @throws BufferExceededException if all buffer frames are pinned
+ */
+    PageGuard BufMgr::readPage(File* file, const PageId pageNo, const LatchMode mode) {
+        const FrameId frameNo = pinFrame(file, pageNo);
+	//the pin keeps the frame from being reused while we wait for the latch
+        bufDescTable[frameNo].latch.lock(mode);
+        if (mode == LATCH_EXCLUSIVE) {
+            bufDescTable[frameNo].beginWrite();
+        }
+        return PageGuard(this, frameNo, &bufPool[frameNo], mode);
+    }
+
+    PageGuard BufMgr::tryReadPage(File* file, const PageId pageNo, const LatchMode mode) {
+        BufShard& shard = shardOf(file, pageNo);
         FrameId frameNo;
-        try {
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (!pinIfPresent(shard, file, pageNo, frameNo)) {
+                return PageGuard();
+            }
+            shard.stats.accesses++;
+	//a page still being read in is not cached yet
+            if (!bufDescTable[frameNo].valid) {
+                unPinFrame(frameNo, false);
+                return PageGuard();
+            }
+        }
+	//a busy latch is left for the caller to wait for where it may block
+        if (!bufDescTable[frameNo].latch.tryLock(mode)) {
+            return PageGuard(this, frameNo, &bufPool[frameNo], LATCH_NONE);
+        }
+        if (mode == LATCH_EXCLUSIVE) {
+            bufDescTable[frameNo].beginWrite();
+        }
+        return PageGuard(this, frameNo, &bufPool[frameNo], mode);
+    }
+
+/*
+ * Pins the frame holding (file, pageNo), reading the page into a newly allocated frame
+ * if it is not in the buffer pool. Shared by both forms of readPage().
+ * The victim frame is claimed before the shard's lock is taken, so the page may have been read
+ * in by another thread in the meantime; the claim is then handed back.
+ * The page is read with the shard unlocked. Its frame goes into the hashtable first, pinned, invalid
+ * and exclusively latched, and threads that find it there wait for the latch.
+ */
+    FrameId BufMgr::pinFrame(File* file, const PageId pageNo) {
+        if (file->page_size() > frameSize) {
+            throw InvalidPageSizeException(file->page_size(), file->filename());
+        }
+        BufShard& shard = shardOf(file, pageNo);
+        FrameId frameNo;
+        bool present;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.stats.accesses++;
 		//check to see if page is in buffer pool
-            hashTable->lookup(file, pageNo, frameNo);
-		//set refbit and increment pin counts if page if buffer pool
-            bufDescTable[frameNo].refbit = true;
-            bufDescTable[frameNo].pinCnt++;
-        } catch(HashNotFoundException& e) {
+            present = pinIfPresent(shard, file, pageNo, frameNo);
+        }
+        if (present && awaitLoad(file, pageNo, frameNo)) {
+            return frameNo;
+        }
 	   //if page not in buffer pool
-            try {
+        while (true) {
 		//allocate a buffer frame
-                allocBuf(frameNo);
-		//read page from disk into buffer pool frame    
-                bufPool[frameNo] = file->readPage(pageNo);;
+            allocBuf(shard, frameNo);
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                FrameId found;
+                present = pinIfPresent(shard, file, pageNo, found);
+                if (present) {
+                    releaseClaim(frameNo);
+                    frameNo = found;
+                } else {
+                    if (!evictClaimed(shard, frameNo)) {
+                        continue;
+                    }
+                    try {
 		//insert page into hash table
-                hashTable->insert(file, pageNo, frameNo);
-		//set the frame
-                bufDescTable[frameNo].Set(file, pageNo);
-
-            } catch(BufferExceededException ()) {}
+                        shard.hashTable->insert(file, pageNo, frameNo);
+                    } catch (...) {
+                        releaseClaim(frameNo);
+                        throw;
+                    }
+		//set the frame up for the read, latched until the page is in it
+                    bufDescTable[frameNo].Load(file, pageNo);
+                    bufDescTable[frameNo].latch.lockExclusive();
+                    shard.stats.diskreads++;
+                }
+            }
+            if (present) {
+                if (awaitLoad(file, pageNo, frameNo)) {
+                    return frameNo;
+                }
+                continue;
+            }
+            BufDesc& desc = bufDescTable[frameNo];
+            try {
+		//read page from disk into buffer pool frame    
+                std::lock_guard<std::mutex> io(ioMutexOf(file));
+                file->readPage(pageNo, bufPool[frameNo]);
+            } catch (...) {
+		//give the frame up; threads waiting for the page look it up again
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.hashTable->remove(file, pageNo);
+                desc.file = NULL;
+                desc.pageNo = Page::INVALID_NUMBER;
+                desc.endWrite();
+                desc.latch.unlockExclusive();
+                unPinFrame(frameNo, false);
+                throw;
+            }
+            desc.valid = true;
+            desc.endWrite();
+            desc.latch.unlockExclusive();
+            return frameNo;
         }
-	//Return a pointer to the frame containing the page via the page parameter
-        page = &bufPool[frameNo];
+    }
 
+/*
+ * Waits for a page that pinIfPresent() pinned while another thread was still reading it in.
+ * The reading thread holds the frame's latch exclusively until it is done; if the read failed,
+ * the frame no longer holds the page and the pin is dropped.
+ */
+    bool BufMgr::awaitLoad(File* file, const PageId pageNo, FrameId frame) {
+        BufDesc& desc = bufDescTable[frame];
+        if (!desc.valid) {
+            desc.latch.lockShared();
+            desc.latch.unlockShared();
+        }
+        if (desc.valid && desc.file == file && desc.pageNo == pageNo) {
+            return true;
+        }
+        unPinFrame(frame, false);
+        return false;
     }
 
 /**
@@ -177,28 +609,43 @@ BufMgr::BufMgr(std::uint32_t bufs)
  * @param PageNo  Page number
  * @param dirty		True if the page to be unpinned needs to be marked dirty	
  * @throws  PageNotPinnedException If the page is not already pinned (i.e. pin count already 0)
- * @throws HashNotFoundException when page is not in the buffer pool, on the 
- * hashtable to get a frame number
  */
     void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty) {
 
+        BufShard& shard = shardOf(file, pageNo);
+        std::lock_guard<std::mutex> lock(shard.mutex);
         FrameId frameNo;
 
         try {
 	    //find the frame containing (file, PageNo)
-            hashTable->lookup(file, pageNo, frameNo);
+            shard.hashTable->lookup(file, pageNo, frameNo);
 		//Throws PAGENOTPINNED if the pin count is already 0.
-            if(bufDescTable[frameNo].pinCnt == 0){
+            if(!unPinFrame(frameNo, dirty)){
                 throw PageNotPinnedException(file->filename(), bufDescTable[frameNo].pageNo, frameNo);
-            }else if(bufDescTable[frameNo].pinCnt > 0){
-		    //set dirty bit if dirty is true
-                if(dirty){
-                    bufDescTable[frameNo].dirty = true;
-                }
-		    //Decrements the pinCnt of the frame
-                bufDescTable[frameNo].pinCnt = bufDescTable[frameNo].pinCnt - 1;
             }
-        }catch(HashNotFoundException()){}//does nothing}
+        } catch (const HashNotFoundException&) {
+            // does nothing
+        }
+    }
+
+/*
+ * Drops one pin on frameNo, setting the dirty bit first if dirty is true. The pin count is
+ * decremented with a compare-and-swap so that it never goes below zero.
+ * Returns false, changing nothing, if the frame is not pinned.
+ */
+    bool BufMgr::unPinFrame(FrameId frameNo, const bool dirty) {
+        BufDesc& desc = bufDescTable[frameNo];
+        std::uint32_t state = desc.state.load();
+        do {
+            if((state & BufDesc::PIN_MASK) == 0){
+                return false;
+            }
+	    //set dirty while the pin is still held, so the frame cannot have been reused
+            if(dirty){
+                desc.markDirty();
+            }
+        } while(!desc.state.compare_exchange_weak(state, state - 1));
+        return true;
     }
 
 /**
@@ -210,13 +657,68 @@ BufMgr::BufMgr(std::uint32_t bufs)
  * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
  */
     void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) {
+        page = &bufPool[allocFrame(file, pageNo)]; //return a pointer to the buffer frame allocated for the page
+    }
+
+/**
+ * Allocates a new, empty page in the file and returns a guard holding the pin on its frame.
+ *
+ * @param file   	File object
+ * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+ * @param mode  	Mode in which to latch the frame
+ * @return  Guard pinning the frame holding the new page
+ */
+    PageGuard BufMgr::allocPage(File* file, PageId &pageNo, const LatchMode mode) {
+        const FrameId frameNo = allocFrame(file, pageNo);
+        bufDescTable[frameNo].latch.lock(mode);
+        if (mode == LATCH_EXCLUSIVE) {
+            bufDescTable[frameNo].beginWrite();
+        }
+        return PageGuard(this, frameNo, &bufPool[frameNo], mode);
+    }
+
+/*
+ * Allocates a new page in the file and pins a frame for it. Shared by both forms of allocPage().
+ * The page is allocated in the file first, since its number decides the shard it goes in; it is
+ * deleted again if no frame can be found for it.
+ */
+    FrameId BufMgr::allocFrame(File* file, PageId &pageNo) {
+        if (file->page_size() > frameSize) {
+            throw InvalidPageSizeException(file->page_size(), file->filename());
+        }
+        Page newPage(file->page_size());
+        {
+            std::lock_guard<std::mutex> io(ioMutexOf(file));
+            newPage = file->allocatePage(); //allocate an empty page in the specific file
+        }
+        pageNo = newPage.page_number(); //return page number of newly allocated page
+        BufShard& shard = shardOf(file, pageNo);
         FrameId frameNo;
-        allocBuf(frameNo); //obtain a buffer pool frame
-        bufPool[frameNo] = file->allocatePage(); //allocate an empty page in the specific file
-        page = &bufPool[frameNo]; //return a pointer to the buffer frame allocated for the page
-        pageNo = page->page_number(); //return page number of newly allocated page
-        hashTable->insert(file, pageNo, frameNo); //insert an entry into the hash table
-        bufDescTable[frameNo].Set(file, pageNo); //set up the frame
+        while (true) {
+            try {
+                allocBuf(shard, frameNo); //obtain a buffer pool frame
+            } catch (...) {
+                std::lock_guard<std::mutex> io(ioMutexOf(file));
+                file->deletePage(pageNo);
+                throw;
+            }
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (!evictClaimed(shard, frameNo)) {
+                continue;
+            }
+		//copy assignment reuses the frame's storage, which is large enough for any page it may hold
+            bufPool[frameNo] = newPage;
+            shard.stats.diskreads++;
+            try {
+                shard.hashTable->insert(file, pageNo, frameNo); //insert an entry into the hash table
+            } catch (...) {
+                releaseClaim(frameNo);
+                throw;
+            }
+            bufDescTable[frameNo].Set(file, pageNo); //set up the frame
+            bufDescTable[frameNo].endWrite();
+            return frameNo;
+        }
     }
 
 /**
@@ -232,39 +734,54 @@ BufMgr::BufMgr(std::uint32_t bufs)
  * @throws  PagePinnedException If any page of the file is pinned in the buffer pool 
  * @throws BadBufferException If any frame allocated to the file is found to be invalid
  */
-    void BufMgr::flushFile(const File* file) 
+    void BufMgr::flushFile(const File* file, const FlushMode mode) 
     {
-	//loop to scan for pages belong to the file
-        for (std::uint32_t i = 0; i < numBufs; i++)
+        if (mode == FLUSH_KEEP)
+        {
+            writeBackFile(file);
+            return;
+        }
+	//loop over the shards, scanning each one's frames for pages belonging to the file
+        for (std::uint32_t s = 0; s < numShards; s++)
+        {
+            BufShard& shard = shards[s];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (FrameId i = shard.firstFrame; i < shard.firstFrame + shard.numFrames; i++)
   {
     BufDesc *currDesc = &bufDescTable[i];
-    bufStats.accesses++;
+    shard.stats.accesses++;
 	//condition for file to match
     if (file == currDesc->file)
     {
-	    //throw BadBufferException if an invalid page belonging to the file is encountered
-      if (!currDesc->valid)
+	    // throw PagePinnedException if some page of the file is pinned, or still being read in
+      if (currDesc->pinCnt() > 0)
       {
-        throw BadBufferException(currDesc->frameNo, currDesc->dirty, currDesc->valid, currDesc->refbit);
+        throw PagePinnedException(file->filename(), currDesc->pageNo, currDesc->frameNo);
         break;
       }
-	    // throw PagePinnedException if some page of the file is pinned
-      if (currDesc->pinCnt > 0)
+	    //throw BadBufferException if an invalid page belonging to the file is encountered
+      if (!currDesc->valid)
       {
-        throw PagePinnedException(file->filename(), currDesc->pageNo, currDesc->frameNo);
+        throw BadBufferException(currDesc->frameNo, currDesc->isDirty(), currDesc->valid, currDesc->refbit());
         break;
       }
 	//flush the page to disk and then set the dirty bit for the page to false if page is dir
-      if (currDesc->dirty)
+      if (currDesc->isDirty())
       {
         Page dirtyPage = bufPool[currDesc->frameNo];
-        currDesc->file->writePage(dirtyPage);
-        currDesc->dirty = false;
-        bufStats.diskwrites++;
+        {
+          std::lock_guard<std::mutex> io(ioMutexOf(file));
+          currDesc->file.load()->writePage(dirtyPage);
+        }
+        currDesc->markClean();
+        shard.stats.diskwrites++;
       }
 	    //remove the page from the hashtable
-      hashTable->remove(file, currDesc->pageNo);
+      shard.hashTable->remove(file, currDesc->pageNo);
+      currDesc->beginWrite();
       currDesc->Clear();
+      currDesc->endWrite();
+      freeFrame(shard, currDesc->frameNo);
     }
     else
     {
@@ -272,6 +789,81 @@ BufMgr::BufMgr(std::uint32_t bufs)
     }
 
     }
+        }
+    }
+
+/*
+ * Writes the dirty pages of the file to disk and leaves them cached. The dirty frames of the file are
+ * pinned, without setting their refbits, under the shard's lock so that they stay put. Each is then
+ * copied under a shared latch, which waits for an exclusive holder to finish, and the dirty bit is
+ * cleared before the copy so that a change made after it marks the page dirty again. The copy is
+ * written with no latch held, so readers are never held up by the disk.
+ *
+ * @param file   	File object
+ */
+    void BufMgr::writeBackFile(const File* file)
+    {
+	//copying into an existing page of the file's size reuses its buffer, so nothing is allocated under a latch
+        Page snapshot(file->page_size());
+        std::vector<FrameId> frames;
+        for (std::uint32_t s = 0; s < numShards; s++)
+        {
+            BufShard& shard = shards[s];
+            frames.clear();
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                for (FrameId i = shard.firstFrame; i < shard.firstFrame + shard.numFrames; i++)
+                {
+                    BufDesc& desc = bufDescTable[i];
+                    shard.stats.accesses++;
+                    if (desc.file == file && desc.valid && desc.isDirty())
+                    {
+                        desc.pinUnreferenced();
+                        frames.push_back(i);
+                    }
+                }
+            }
+
+            std::size_t f = 0;
+            try
+            {
+                for (; f < frames.size(); f++)
+                {
+                    BufDesc& desc = bufDescTable[frames[f]];
+                    bool dirty;
+                    {
+		//pages marked dirty from here on stay dirty when the write ends
+                        ScopedLatch latch(desc.latch, LATCH_SHARED);
+                        dirty = desc.isDirty();
+                        if (dirty)
+                        {
+                            desc.beginWriteBack();
+                            snapshot = bufPool[desc.frameNo];
+                        }
+                    }
+                    if (dirty)
+                    {
+                        {
+                            std::lock_guard<std::mutex> io(ioMutexOf(file));
+                            desc.file.load()->writePage(snapshot);
+                        }
+                        desc.endWriteBack();
+                        std::lock_guard<std::mutex> lock(shard.mutex);
+                        shard.stats.diskwrites++;
+                    }
+                    unPinFrame(desc.frameNo, false);
+                }
+            }
+            catch (...)
+            {
+		//the page that failed is still dirty, and no frame may be left pinned
+                for (; f < frames.size(); f++)
+                {
+                    unPinFrame(frames[f], false);
+                }
+                throw;
+            }
+        }
     }
 
 /**
@@ -285,16 +877,22 @@ BufMgr::BufMgr(std::uint32_t bufs)
  */
     void BufMgr::disposePage(File* file, const PageId PageNo) {
         FrameId frameNo = -1;
+        BufShard& shard = shardOf(file, PageNo);
+        std::lock_guard<std::mutex> lock(shard.mutex);
         try {
 	    //find the particular page 
-            hashTable->lookup(file, PageNo, frameNo);
+            shard.hashTable->lookup(file, PageNo, frameNo);
 		//remove the page from the hashtable and free frame
-            hashTable->remove(bufDescTable[frameNo].file, bufDescTable[frameNo].pageNo);
+            shard.hashTable->remove(bufDescTable[frameNo].file, bufDescTable[frameNo].pageNo);
+            bufDescTable[frameNo].beginWrite();
             bufDescTable[frameNo].Clear();
-        } catch (HashNotFoundException() ) {
+            bufDescTable[frameNo].endWrite();
+            freeFrame(shard, frameNo);
+        } catch (const HashNotFoundException&) {
             // do nothing
         }
 	    //delete page from file
+        std::lock_guard<std::mutex> io(ioMutexOf(file));
         file->deletePage(PageNo);
 
     }
@@ -304,17 +902,103 @@ BufMgr::BufMgr(std::uint32_t bufs)
         BufDesc* tmpbuf;
         int validFrames = 0;
 
-        for (std::uint32_t i = 0; i < numBufs; i++)
+        for (std::uint32_t s = 0; s < numShards; s++)
         {
-            tmpbuf = &(bufDescTable[i]);
-            std::cout << "FrameNo:" << i << " ";
-            tmpbuf->Print();
+            std::lock_guard<std::mutex> lock(shards[s].mutex);
+            for (FrameId i = shards[s].firstFrame; i < shards[s].firstFrame + shards[s].numFrames; i++)
+            {
+                tmpbuf = &(bufDescTable[i]);
+                std::cout << "FrameNo:" << i << " ";
+                tmpbuf->Print();
 
-            if (tmpbuf->valid == true)
-                validFrames++;
+                if (tmpbuf->valid == true)
+                    validFrames++;
+            }
         }
 
         std::cout << "Total Number of Valid Frames:" << validFrames << "\n";
     }
 
+//----------------------------------------
+// PageGuard
+//----------------------------------------
+
+    PageGuard::PageGuard()
+        : buf_mgr_(NULL), frame_(0), page_(NULL), dirty_(false), mode_(LATCH_NONE) {
+    }
+
+    PageGuard::PageGuard(BufMgr* buf_mgr, FrameId frame, Page* page, LatchMode mode)
+        : buf_mgr_(buf_mgr), frame_(frame), page_(page), dirty_(false), mode_(mode) {
+    }
+
+    PageGuard::PageGuard(PageGuard&& other)
+        : buf_mgr_(other.buf_mgr_), frame_(other.frame_), page_(other.page_), dirty_(other.dirty_), mode_(other.mode_) {
+        other.buf_mgr_ = NULL;
+        other.page_ = NULL;
+        other.dirty_ = false;
+        other.mode_ = LATCH_NONE;
+    }
+
+    PageGuard& PageGuard::operator=(PageGuard&& other) {
+        if (this != &other) {
+		//drop the pin this guard holds before taking over the other one
+            unlatchAndUnpin();
+            buf_mgr_ = other.buf_mgr_;
+            frame_ = other.frame_;
+            page_ = other.page_;
+            dirty_ = other.dirty_;
+            mode_ = other.mode_;
+            other.buf_mgr_ = NULL;
+            other.page_ = NULL;
+            other.dirty_ = false;
+            other.mode_ = LATCH_NONE;
+        }
+        return *this;
+    }
+
+/*
+ * Destructors must not throw, so a pin that was already dropped through unPinPage() is
+ * ignored here; call release() to have it reported.
+ */
+    PageGuard::~PageGuard() {
+        unlatchAndUnpin();
+    }
+
+    void PageGuard::release() {
+        BufMgr* bufMgr = buf_mgr_;
+        if (!unlatchAndUnpin()) {
+            const BufDesc& desc = bufMgr->bufDescTable[frame_];
+            throw PageNotPinnedException(desc.file.load()->filename(), desc.pageNo, frame_);
+        }
+    }
+
+    void PageGuard::latch(const LatchMode mode) {
+        assert(buf_mgr_ != NULL && mode_ == LATCH_NONE);
+        BufDesc& desc = buf_mgr_->bufDescTable[frame_];
+        desc.latch.lock(mode);
+        if (mode == LATCH_EXCLUSIVE) {
+            desc.beginWrite();
+        }
+        mode_ = mode;
+    }
+
+    bool PageGuard::unlatchAndUnpin() {
+        if (buf_mgr_ == NULL) {
+            return true;
+        }
+        BufMgr* bufMgr = buf_mgr_;
+        buf_mgr_ = NULL;
+        page_ = NULL;
+	//the latch must be free by the time the frame can be reused
+        BufDesc& desc = bufMgr->bufDescTable[frame_];
+        if (mode_ == LATCH_EXCLUSIVE) {
+            desc.endWrite();
+        }
+        desc.latch.unlock(mode_);
+        mode_ = LATCH_NONE;
+        const bool pinned = bufMgr->unPinFrame(frame_, dirty_);
+        dirty_ = false;
+        return pinned;
+    }
+
 }
@@ -7,8 +7,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
 #include "file.h"
 #include "bufHashTbl.h"
+#include "page_latch.h"
 
 namespace badgerdb {
 
@@ -17,23 +23,41 @@ namespace badgerdb {
 */
 class BufMgr;
 
+/**
+* @brief What BufMgr::flushFile() does with the frames of the file
+*/
+enum FlushMode
+{
+	/**
+   * Write back dirty pages and evict every page of the file; fails if any of them is pinned
+	 */
+  FLUSH_EVICT,
+
+	/**
+   * Write back dirty pages and keep them cached; pinned pages are written too, as of the moment they are copied
+	 */
+  FLUSH_KEEP
+};
+
 /**
 * @brief Class for maintaining information about buffer pool frames
 */
 class BufDesc {
 
 	friend class BufMgr;
+	friend class PageGuard;
 
  private:
 	/**
-   * Pointer to file to which corresponding frame is assigned
+   * Pointer to file to which corresponding frame is assigned.  Atomic, like pageNo and valid, since optimistic
+   * readers check which page the frame holds without any lock.
 	 */
-  File* file;
+  std::atomic<File*> file;
 
 	/**
    * Page within file to which corresponding frame is assigned
 	 */
-  PageId pageNo;
+  std::atomic<PageId> pageNo;
 
 	/**
    * Frame number of the frame, in the buffer pool, being used
@@ -41,35 +65,171 @@ class BufDesc {
   FrameId	frameNo;
 
 	/**
-   * Number of times this page has been pinned
+   * NUMA partition the frame's memory was placed in
+	 */
+  std::uint32_t numaNode;
+
+	/**
+   * Pin count, reference bit and eviction claim of the frame, packed into one word so that the clock can test and
+   * take a victim with a single compare-and-swap and a PageGuard can drop its pin without going through the hash
+   * table.  The low bits count pins; see REFBIT and CLAIMED for the others.
+	 */
+  std::atomic<std::uint32_t> state;
+
+	/**
+   * Bit of state set when the frame is referenced, and cleared by the clock as it passes
+	 */
+  static const std::uint32_t REFBIT = 1u << 30;
+
+	/**
+   * Bit of state set while a thread that chose the frame as its clock victim is evicting it.  Only that thread
+   * clears it; pins taken meanwhile keep it, and make the thread give the frame up.
+	 */
+  static const std::uint32_t CLAIMED = 1u << 31;
+
+	/**
+   * Bits of state counting pins
 	 */
-  int pinCnt;
+  static const std::uint32_t PIN_MASK = REFBIT - 1;
 
 	/**
-   * True if page is dirty;  false otherwise
+   * Dirty state of the page: DIRTY while it differs from its copy on disk, with REDIRTIED also set when it was
+   * marked dirty after a write-back began.  Kept in one atomic word, set when a pin is dropped outside the buffer
+   * pool lock, so that a write-back clears DIRTY only if the page was not dirtied again while it was written.
 	 */
-  bool dirty;
+  std::atomic<std::uint32_t> dirtyFlags;
+
+	/**
+   * Bit of dirtyFlags set while the page differs from its copy on disk
+	 */
+  static const std::uint32_t DIRTY = 1u << 0;
+
+	/**
+   * Bit of dirtyFlags set with DIRTY, and cleared when a write-back of the page begins
+	 */
+  static const std::uint32_t REDIRTIED = 1u << 1;
 
 	/**
    * True if page is valid
 	 */
-  bool valid;
+  std::atomic<bool> valid;
 
 	/**
-   * Has this buffer frame been reference recently
+   * Reader/writer latch protecting the contents of the page in the frame.  Taken only by pins that ask for it,
+   * after the frame is pinned.
 	 */
-  bool refbit;
+  PageLatch latch;
 
 	/**
-   * Initialize buffer frame for a new user
+   * Version of the frame's contents, for optimistic reads.  Odd while the page in the frame is being modified
+   * under an exclusive latch or the frame is being given to another page; advanced past the old value when that
+   * ends.  A reader that sees the same even version before and after reading the page read a consistent page.
+	 */
+  std::atomic<std::uint64_t> version;
+
+	/**
+   * Makes the version odd, announcing that the frame is changing.  Does nothing if it is already odd.
+	 */
+  void beginWrite()
+	{
+    version.fetch_or(1, std::memory_order_acq_rel);
+  }
+
+	/**
+   * Makes the version even again once the frame has stopped changing.
+	 */
+  void endWrite()
+	{
+    version.fetch_add(1, std::memory_order_release);
+  }
+
+	/**
+   * Returns true if the page differs from its copy on disk
+	 */
+  bool isDirty() const
+	{
+    return (dirtyFlags.load() & DIRTY) != 0;
+  }
+
+	/**
+   * Marks the page dirty, and dirtied again if a write-back of it is under way
+	 */
+  void markDirty()
+	{
+    dirtyFlags.store(DIRTY | REDIRTIED);
+  }
+
+	/**
+   * Marks the page clean, once it is written by a thread no one else can mark it dirty behind
+	 */
+  void markClean()
+	{
+    dirtyFlags.store(0);
+  }
+
+	/**
+   * Starts a write-back of the page, which may be pinned and marked dirty while it is written.  Call before
+   * copying the page.
+	 */
+  void beginWriteBack()
+	{
+    dirtyFlags.fetch_and(~REDIRTIED);
+  }
+
+	/**
+   * Ends a write-back that succeeded, marking the page clean unless it was marked dirty since it began
+	 */
+  void endWriteBack()
+	{
+    std::uint32_t written = DIRTY;
+    dirtyFlags.compare_exchange_strong(written, 0);
+  }
+
+	/**
+   * Returns the number of times this page is pinned
+	 */
+  int pinCnt() const
+	{
+    return state.load() & PIN_MASK;
+  }
+
+	/**
+   * Returns true if this buffer frame has been referenced recently
+	 */
+  bool refbit() const
+	{
+    return (state.load() & REFBIT) != 0;
+  }
+
+	/**
+   * Pins the frame and sets its reference bit.  A clock claim on the frame is kept.
+	 */
+  void pin()
+	{
+    std::uint32_t current = state.load();
+    while (!state.compare_exchange_weak(current, (current + 1) | REFBIT))
+    {
+    }
+  }
+
+	/**
+   * Pins the frame without setting its reference bit, for pins that are not accesses to the page.
+	 */
+  void pinUnreferenced()
+	{
+    state.fetch_add(1);
+  }
+
+	/**
+   * Initialize buffer frame for a new user.  A clock claim on the frame is kept, so the claiming thread still
+   * owns it.
 	 */
   void Clear()
 	{
-    pinCnt = 0;
+    state.fetch_and(CLAIMED);
 		file = NULL;
 		pageNo = Page::INVALID_NUMBER;
-    dirty = false;
-    refbit = false;
+    markClean();
 		valid = false;
   };
 
@@ -84,38 +244,194 @@ class BufDesc {
 	{ 
 		file = filePtr;
     pageNo = pageNum;
-    pinCnt = 1;
-    dirty = false;
+    state = 1 | REFBIT;
+    markClean();
     valid = true;
-    refbit = true;
+  }
+
+	/**
+	 * Assigns the frame to a page that the calling thread is about to read in.  The frame is pinned once for that
+	 * thread but stays invalid until the read completes, so that threads finding the page in the hash table
+	 * meanwhile know to wait for it.  A clock claim on the frame is dropped.
+	 *
+	 * @param filePtr	File object
+	 * @param pageNum	Page number in the file
+	 */
+  void Load(File* filePtr, PageId pageNum)
+	{
+		file = filePtr;
+    pageNo = pageNum;
+    state = 1 | REFBIT;
+    markClean();
+    valid = false;
   }
 
   void Print()
 	{
 		if(file != NULL)
 		{
-			std::cout << "file:" << file->filename() << " ";
+			std::cout << "file:" << file.load()->filename() << " ";
 			std::cout << "pageNo:" << pageNo << " ";
 		}
 		else
 			std::cout << "file:NULL ";
 
 		std::cout << "valid:" << valid << " ";
-		std::cout << "pinCnt:" << pinCnt << " ";
-		std::cout << "dirty:" << dirty << " ";
-		std::cout << "refbit:" << refbit << "\n";
+		std::cout << "pinCnt:" << pinCnt() << " ";
+		std::cout << "dirty:" << isDirty() << " ";
+		std::cout << "refbit:" << refbit() << "\n";
   }
 
 	/**
    * Constructor of BufDesc class 
 	 */
   BufDesc()
+		: state(0), dirtyFlags(0), version(0)
 	{
   	Clear();
   }
 };
 
 
+/**
+* @brief Pin on a buffer pool frame that is released when the guard goes out of scope
+*
+* A guard is returned by the BufMgr::readPage and BufMgr::allocPage overloads
+* that take no Page pointer.  It remembers the frame it pinned, so unpinning
+* is a single atomic decrement rather than a hash table lookup.  Guards can be
+* moved but not copied; a moved-from guard holds no pin.
+*
+* A guard may also hold the frame's latch in shared or exclusive mode, as
+* requested when the page was pinned.  The latch is released before the pin.
+* While an exclusive guard is held the frame's version is odd, so optimistic
+* readers retry instead of using what they read.
+*/
+class PageGuard {
+
+	friend class BufMgr;
+
+ public:
+	/**
+   * Constructs a guard that holds no pin
+	 */
+  PageGuard();
+
+  PageGuard(PageGuard&& other);
+
+  PageGuard& operator=(PageGuard&& other);
+
+  PageGuard(const PageGuard&) = delete;
+
+  PageGuard& operator=(const PageGuard&) = delete;
+
+	/**
+   * Unlatches and unpins the frame, marking it dirty first if markDirty() was called
+	 */
+  ~PageGuard();
+
+	/**
+   * Marks the page dirty, so that it is written back before its frame is reused
+	 */
+  void markDirty()
+  {
+    dirty_ = true;
+  }
+
+	/**
+	 * Unlatches and unpins the frame now instead of when the guard is destroyed.  Does nothing
+	 * if the guard holds no pin.
+	 *
+   * @throws  PageNotPinnedException If the frame was unpinned behind the guard's back with BufMgr::unPinPage
+	 */
+  void release();
+
+	/**
+	 * Latches the pinned frame in the given mode, waiting for the latch if needed.  For guards that hold a pin
+	 * but no latch, such as those BufMgr::tryReadPage() returns when the latch was busy.
+	 *
+	 * @param mode  	Mode in which to latch the frame
+	 */
+  void latch(const LatchMode mode);
+
+	/**
+   * Returns the pinned page, or NULL if the guard holds no pin
+	 */
+  Page* get() const
+  {
+    return page_;
+  }
+
+  Page& operator*() const
+  {
+    return *page_;
+  }
+
+  Page* operator->() const
+  {
+    return page_;
+  }
+
+	/**
+   * Returns true if the guard holds a pin
+	 */
+  explicit operator bool() const
+  {
+    return page_ != NULL;
+  }
+
+	/**
+   * Returns the frame that is pinned
+	 */
+  FrameId frame() const
+  {
+    return frame_;
+  }
+
+	/**
+   * Returns the mode in which the frame is latched
+	 */
+  LatchMode mode() const
+  {
+    return mode_;
+  }
+
+ private:
+  PageGuard(BufMgr* buf_mgr, FrameId frame, Page* page, LatchMode mode);
+
+	/**
+   * Releases the latch and the pin held by the guard, if any, and empties it
+	 *
+	 * @return  False if the frame was no longer pinned
+	 */
+  bool unlatchAndUnpin();
+
+	/**
+   * Buffer manager owning the frame; NULL if the guard holds no pin
+	 */
+  BufMgr* buf_mgr_;
+
+	/**
+   * Frame that is pinned
+	 */
+  FrameId frame_;
+
+	/**
+   * Page held in the pinned frame
+	 */
+  Page* page_;
+
+	/**
+   * True if the page is to be marked dirty when the pin is released
+	 */
+  bool dirty_;
+
+	/**
+   * Mode in which the frame is latched
+	 */
+  LatchMode mode_;
+};
+
+
 /**
 * @brief Class to maintain statistics of buffer usage 
 */
@@ -136,12 +452,22 @@ struct BufStats
 	 */
   int diskwrites;
 
+	/**
+   * Number of accesses that found the page in a frame on the accessing thread's NUMA node
+	 */
+  int localhits;
+
+	/**
+   * Number of accesses that found the page in a frame on another NUMA node
+	 */
+  int remotehits;
+
 	/**
    * Clear all values 
 	 */
   void clear()
   {
-		accesses = diskreads = diskwrites = 0;
+		accesses = diskreads = diskwrites = localhits = remotehits = 0;
   }
       
 	/**
@@ -154,26 +480,159 @@ struct BufStats
 };
 
 
+/**
+* @brief Frames of a shard placed on one NUMA node, with their own clock
+*/
+struct FramePartition
+{
+	/**
+   * First frame of the partition
+	 */
+  FrameId firstFrame;
+
+	/**
+   * Number of frames in the partition; may be 0 in a shard with fewer frames than there are nodes
+	 */
+  std::uint32_t numFrames;
+
+	/**
+   * Number of frames the partition's clock has passed; the hand is at firstFrame + clockHand % numFrames.
+   * Sweeping threads advance it by BufMgr::CLOCK_BATCH frames with a single fetch_add and examine those frames on
+   * their own, over as many calls to allocBuf() as it takes.
+	 */
+  std::atomic<std::uint64_t> clockHand;
+
+	/**
+   * Frames of the partition known to be free, overflowing from threads' free-frame caches.  Entries are only
+   * hints: a frame may have been taken by the clock since it was put here, so it is claimed before use.
+	 */
+  std::vector<FrameId> freeFrames;
+
+	/**
+   * Number of entries in freeFrames, read without the lock so that empty lists are skipped
+	 */
+  std::atomic<std::uint32_t> freeCount;
+
+	/**
+   * Lock protecting freeFrames
+	 */
+  std::mutex freeMutex;
+
+  FramePartition()
+		: firstFrame(0), numFrames(0), clockHand(0), freeCount(0)
+  {
+  }
+};
+
+
+/**
+* @brief Independent slice of the buffer pool
+*
+* Each shard owns a contiguous range of frames, with its own hash table, clocks, lock and statistics.  A page
+* is always cached in the shard its (File, PageId) hashes to.  The shard's frames are split into one partition
+* per NUMA node, each with its own clock.
+*/
+struct BufShard
+{
+	/**
+   * First frame of the shard
+	 */
+  FrameId firstFrame;
+
+	/**
+   * Number of frames in the shard
+	 */
+  std::uint32_t numFrames;
+
+	/**
+   * Partitions of the shard's frames, one per NUMA node
+	 */
+  FramePartition *partitions;
+
+	/**
+   * Hash table mapping (File, page) to frame for the pages in the shard
+	 */
+  BufHashTbl *hashTable;
+
+	/**
+   * Protects the hash table, the assignment of the shard's frames to pages and the statistics.  Pin counts, dirty
+   * bits, latches and the clock are updated without it.
+	 */
+  std::mutex mutex;
+
+	/**
+   * Usage statistics of the shard
+	 */
+  BufStats stats;
+
+  BufShard()
+		: firstFrame(0), numFrames(0), partitions(NULL), hashTable(NULL)
+  {
+  }
+};
+
+
 /**
 * @brief The central class which manages the buffer pool including frame allocation and deallocation to pages in the file 
+*
+* The pool can be split into shards (see BufShard) so that threads faulting in different pages do not contend for
+* one lock or one clock.  A page can only be cached in its own shard, so a workload whose hot pages crowd one shard
+* has fewer frames to use than an unsharded pool would give it.
+*
+* The frames can also be partitioned across NUMA nodes.  Each partition's memory is first touched by a thread
+* running on its node, and a thread faulting a page in takes a frame from its own node's partition when it can.
+*
+* Frames emptied by flushFile() and disposePage() are kept on free lists, cached per thread, and handed out before
+* the clock is swept.  A thread that frees and allocates pages at about the same rate rarely takes a shared lock.
+*
+* Every frame is allocated for pages of one size, chosen when the pool is built, and holds pages of any file whose
+* page size is no larger.  Files with very different page sizes are best given a pool each, so that small pages do
+* not take up large frames.
 */
 class BufMgr 
 {
+	friend class PageGuard;
+
  private:
 	/**
-   * Current position of clockhand in our buffer pool
+   * Number of frames a thread takes from a clock at a time
 	 */
-  FrameId clockHand;
+  static const std::uint32_t CLOCK_BATCH = 8;
 
 	/**
    * Number of frames in the buffer pool
 	 */
   std::uint32_t numBufs;
+
+	/**
+   * Size in bytes of the largest page a frame can hold
+	 */
+  std::size_t frameSize;
+
+	/**
+   * Number of times readPageOptimistic tries to read a page without pinning it before falling back to a pin
+	 */
+  static const int OPTIMISTIC_ATTEMPTS = 4;
 	
 	/**
-   * Hash table mapping (File, page) to frame
+   * Shards the buffer pool is split into
 	 */
-  BufHashTbl *hashTable;
+  BufShard *shards;
+
+	/**
+   * Number of shards
+	 */
+  std::uint32_t numShards;
+
+	/**
+   * Number of NUMA partitions each shard's frames are split into
+	 */
+  std::uint32_t numNodes;
+
+	/**
+   * Partitions of all shards; shard i's are partitions[i * numNodes] onwards
+	 */
+  FramePartition *partitions;
 
 	/**
    * Array of BufDesc objects to hold information corresponding to every frame allocation from 'bufPool' (the buffer pool)
@@ -181,24 +640,170 @@ class BufMgr
   BufDesc *bufDescTable;
 
 	/**
-   * Maintains Buffer pool usage statistics 
+   * Buffer pool usage statistics returned by getBufStats(); the counts are kept per shard
 	 */
   BufStats bufStats;
 
 	/**
-   * Advance clock to next frame in the buffer pool
+   * Number of locks the buffer manager's calls into File are spread over
 	 */
-  void advanceClock();
+  static const std::uint32_t IO_LOCKS = 16;
 
 	/**
-	 * Allocate a free frame.  
+   * Serialize the buffer manager's calls into File, which is not threadsafe.  A file's calls all take the lock its
+   * name hashes to, since File objects opened on the same name share one stream; calls into different files go
+   * ahead in parallel.  Taken after a shard's lock, if one is held.
+	 */
+  std::mutex ioMutexes[IO_LOCKS];
+
+	/**
+	 * Returns the lock serializing calls into the given file.
+	 *
+	 * @param file   	File object
+	 */
+  std::mutex& ioMutexOf(const File* file);
+
+	/**
+	 * Returns the shard the given page is cached in.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file
+	 */
+  BufShard& shardOf(const File* file, const PageId PageNo);
+
+	/**
+	 * Claim a victim frame in the shard with the clock algorithm, without taking the shard's lock.  The frame is
+	 * marked CLAIMED and must then be evicted with evictClaimed() or handed back with releaseClaim().  Frames on the
+	 * calling thread's NUMA node are tried first.
 	 *
+	 * @param shard   	Shard to take the frame from
 	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
 	 * @throws BufferExceededException If no such buffer is found which can be allocated
 	 */
-  void allocBuf(FrameId & frame);
+  void allocBuf(BufShard & shard, FrameId & frame);
+
+	/**
+	 * Claim a victim frame in one partition with the clock algorithm.
+	 *
+	 * @param partition	Partition to take the frame from
+	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+	 * @return  False if every frame of the partition is pinned
+	 */
+  bool allocBuf(FramePartition & partition, FrameId & frame);
+
+	/**
+	 * Returns the NUMA partition of the calling thread
+	 */
+  std::uint32_t currentNode() const;
+
+	/**
+	 * Constructs the pages of the frames in one NUMA partition. Run on a thread on that node, so that
+	 * the memory each page allocates is placed there on first touch.
+	 *
+	 * @param node	Partition whose frames to construct
+	 */
+  void constructFrames(std::uint32_t node);
+
+	/**
+	 * Empties a frame claimed by allocBuf(), writing its page back if dirty and removing it from the hash table.
+	 * Must be called holding the shard's lock.  If the frame was pinned after it was claimed it is left alone and
+	 * the claim is dropped.  The frame's version is left odd, to be ended when the frame is Set().
+	 *
+	 * @param shard   	Shard holding the frame
+	 * @param frame   	Claimed frame
+	 * @return  False if the claim was dropped and another victim must be found
+	 */
+  bool evictClaimed(BufShard & shard, FrameId frame);
+
+	/**
+	 * Hands back a frame claimed by allocBuf() without giving it to a page.
+	 *
+	 * @param frame   	Claimed frame
+	 */
+  void releaseClaim(FrameId frame);
+
+	/**
+	 * Claims a free frame of the partition from the calling thread's cache, refilling the cache from the
+	 * partition's free list when it runs out.  Takes no lock while the cache holds a frame.
+	 *
+	 * @param partition	Partition to take the frame from
+	 * @param frame   	Frame reference, frame ID of claimed frame returned via this variable
+	 * @return  False if no free frame was found and the clock must be swept
+	 */
+  bool takeFreeFrame(FramePartition & partition, FrameId & frame);
+
+	/**
+	 * Puts a frame that was just cleared in the calling thread's free-frame cache, moving half of the cache
+	 * to the partition's free list when it is full.
+	 *
+	 * @param shard   	Shard holding the frame
+	 * @param frame   	Cleared frame
+	 */
+  void freeFrame(BufShard & shard, FrameId frame);
+
+	/**
+	 * Pins the frame holding the given page if it is in the buffer pool.  Must be called holding the shard's lock.
+	 *
+	 * @param shard   	Shard the page belongs to
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file
+	 * @param frame   	Frame holding the page is returned via this variable
+	 * @return  False if the page is not in the buffer pool
+	 */
+  bool pinIfPresent(BufShard & shard, File* file, const PageId PageNo, FrameId & frame);
+
+	/**
+	 * Waits for the page pinned by pinIfPresent() to be read in, if another thread is still reading it.  Must be
+	 * called without the shard's lock.  If that read failed the pin is dropped.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file
+	 * @param frame   	Pinned frame
+	 * @return  False if the read failed and the page must be looked up again
+	 */
+  bool awaitLoad(File* file, const PageId PageNo, FrameId frame);
+
+	/**
+	 * Pins the frame holding the given page, reading the page into a newly allocated frame if it is not in the pool.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @return  Frame holding the page, with the pin taken for the caller
+	 */
+  FrameId pinFrame(File* file, const PageId PageNo);
+
+	/**
+	 * Allocates a new page in the file and pins a frame for it.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+	 * @return  Frame holding the new page, with the pin taken for the caller
+	 */
+  FrameId allocFrame(File* file, PageId &PageNo);
+
+	/**
+	 * Drops one pin on a frame.  Never takes the pin count below zero.
+	 *
+	 * @param frameNo Frame to unpin
+	 * @param dirty		True if the page in the frame needs to be marked dirty
+	 * @return  False if the frame was not pinned
+	 */
+  bool unPinFrame(FrameId frameNo, const bool dirty);
+
+	/**
+	 * Writes the dirty pages of the file to disk without evicting them, for flushFile() with FLUSH_KEEP.
+	 * The frames are pinned under each shard's lock and copied under their shared latches, with no lock held.
+	 *
+	 * @param file   	File object
+	 */
+  void writeBackFile(const File* file);
 
  public:
+	/**
+   * Frame hint meaning the frame holding a page is not known
+	 */
+  static const FrameId NO_FRAME = 0xffffffff;
+
 	/**
    * Actual buffer pool from which frames are allocated
 	 */
@@ -206,8 +811,15 @@ class BufMgr
 
 	/**
    * Constructor of BufMgr class
-	 */
-  BufMgr(std::uint32_t bufs);
+	 *
+	 * @param bufs   	Number of frames in the buffer pool
+	 * @param shards  Number of shards to split the frames into; at least 1 and at most bufs
+	 * @param numaNodes Number of NUMA partitions to split each shard into, or 0 for one per NUMA node of the machine.
+	 *                Threads on node n use partition n % numaNodes.
+	 * @param frameSize Size in bytes of the largest page a frame can hold; must satisfy Page::isValidSize()
+	 */
+  BufMgr(std::uint32_t bufs, std::uint32_t shards = 1, std::uint32_t numaNodes = 1,
+         std::size_t frameSize = Page::DEFAULT_SIZE);
 	
 	/**
    * Destructor of BufMgr class
@@ -222,9 +834,61 @@ class BufMgr
 	 * @param file   	File object
 	 * @param PageNo  Page number in the file to be read
 	 * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+   * @throws  InvalidPageSizeException If the file's pages are larger than the frames
 	 */
   void readPage(File* file, const PageId PageNo, Page*& page);
 
+	/**
+	 * Reads the given page from the file into a frame and returns a guard holding the pin.
+	 * The page is unpinned when the guard is destroyed, without a hash table lookup.
+	 * Pass LATCH_SHARED to read the page, or LATCH_EXCLUSIVE to modify it, while other threads may be using it;
+	 * the latch is taken after the pin and may wait for other holders.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param mode  	Mode in which to latch the frame
+	 * @return  Guard pinning the frame holding the page
+	 */
+  PageGuard readPage(File* file, const PageId PageNo, const LatchMode mode = LATCH_NONE);
+
+	/**
+	 * Pins and latches the given page like readPage() if it is in the buffer pool, but never reads it from disk
+	 * and never waits for the latch, so that callers that must not block can hand the waiting to another thread.
+	 * If the latch is held in a conflicting mode, the guard returned holds only the pin and its mode() is
+	 * LATCH_NONE; PageGuard::latch() then waits for the latch.  Only hits are counted as accesses.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param mode  	Mode in which to latch the frame
+	 * @return  Guard pinning the frame holding the page, or an empty guard if the page is not cached
+	 */
+  PageGuard tryReadPage(File* file, const PageId PageNo, const LatchMode mode = LATCH_NONE);
+
+	/**
+	 * Runs reader on the given page without pinning or latching it, so concurrent readers of a hot page write no
+	 * shared memory.  The frame the page is expected in is passed in frameHint; the reader runs on that frame's page
+	 * and the frame's version is checked afterwards, and if the page changed or was evicted meanwhile the read is
+	 * retried.  After a few failed attempts, or if the hint is wrong, the page is read under a pin and shared latch
+	 * instead and frameHint is updated.  Start with a hint of NO_FRAME and keep it between calls.
+	 *
+	 * The reader may run more than once and may see a page that is being modified.  It must only copy data out,
+	 * through accessors made for racing a writer such as Page::getRecordOptimistic(), which bounds-check what
+	 * they read, and must not keep pointers into the page.  Exceptions thrown while reading a page that turns out
+	 * to have changed are ignored.
+	 *
+	 * Only writers holding an exclusive latch are detected; pages read optimistically must not be modified under a
+	 * bare pin.  A reader may also race the frame being given to another page; that is safe because frame memory
+	 * is never reallocated (pages are read and copied into the frame's own storage, sized for frameSize), so
+	 * it only ever reads bytes of the frame, and the version check then rejects them.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param frameHint Frame the page was last found in, or NO_FRAME; updated when the page is found elsewhere
+	 * @param reader  Function called with a const Page&
+	 */
+  template <typename Reader>
+  void readPageOptimistic(File* file, const PageId PageNo, FrameId& frameHint, Reader reader);
+
 	/**
 	 * Unpin a page from memory since it is no longer required for it to remain in memory.
 	 *
@@ -242,19 +906,35 @@ class BufMgr
 	 * @param file   	File object
 	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
 	 * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
+   * @throws  InvalidPageSizeException If the file's pages are larger than the frames
 	 */
   void allocPage(File* file, PageId &PageNo, Page*& page); 
 
+	/**
+	 * Allocates a new, empty page in the file and returns a guard holding the pin on its frame.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+	 * @param mode  	Mode in which to latch the frame
+	 * @return  Guard pinning the frame holding the new page
+	 */
+  PageGuard allocPage(File* file, PageId &PageNo, const LatchMode mode = LATCH_NONE);
+
 	/**
 	 * Writes out all dirty pages of the file to disk.
-	 * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
-	 * Otherwise Error returned.
+	 * With FLUSH_EVICT the pages are also removed from the buffer pool, and all the frames assigned to the file need
+	 * to be unpinned before this function can be successfully called.  Otherwise Error returned.
+	 * With FLUSH_KEEP the pages stay cached and may be in use: each dirty page is copied under a shared latch and
+	 * written from the copy, so readers carry on and writers wait only for the copy.  A page is marked clean only
+	 * once it is written, and only if it was not marked dirty meanwhile; a page that failed to be written or was
+	 * changed after it was copied stays dirty for a later flush.
 	 *
 	 * @param file   	File object
-   * @throws  PagePinnedException If any page of the file is pinned in the buffer pool 
+	 * @param mode  	Whether to evict the file's pages after writing them
+   * @throws  PagePinnedException If any page of the file is pinned in the buffer pool, with FLUSH_EVICT
    * @throws BadBufferException If any frame allocated to the file is found to be invalid
 	 */
-  void flushFile(const File* file);
+  void flushFile(const File* file, const FlushMode mode = FLUSH_EVICT);
 
 	/**
 	 * Delete page from file and also from buffer pool if present.
@@ -271,20 +951,56 @@ class BufMgr
   void  printSelf();
 
 	/**
-   * Get buffer pool usage statistics
+   * Get buffer pool usage statistics, summed over the shards
 	 */
-  BufStats & getBufStats()
-  {
-		return bufStats;
-  }
+  BufStats & getBufStats();
 
 	/**
    * Clear buffer pool usage statistics
 	 */
-  void clearBufStats() 
+  void clearBufStats();
+};
+
+/**
+ * The frame's version is read before and after the reader runs; the fence keeps the page reads from moving after
+ * the second version read.
+ */
+template <typename Reader>
+void BufMgr::readPageOptimistic(File* file, const PageId pageNo, FrameId& frameHint, Reader reader)
+{
+  for (int attempt = 0; attempt < OPTIMISTIC_ATTEMPTS && frameHint < numBufs; attempt++)
   {
-		bufStats.clear();
+    const BufDesc& desc = bufDescTable[frameHint];
+    const std::uint64_t version = desc.version.load(std::memory_order_acquire);
+    if ((version & 1) != 0)
+      continue;
+    //the frame holds another page; validated below like the page contents
+    if (!desc.valid || desc.file != file || desc.pageNo != pageNo)
+    {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (desc.version.load(std::memory_order_relaxed) == version)
+        break;
+      continue;
+    }
+    try
+    {
+      reader(static_cast<const Page&>(bufPool[frameHint]));
+    }
+    catch (...)
+    {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (desc.version.load(std::memory_order_relaxed) == version)
+        throw;
+      continue;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (desc.version.load(std::memory_order_relaxed) == version)
+      return;
   }
-};
+
+  PageGuard guard = readPage(file, pageNo, LATCH_SHARED);
+  frameHint = guard.frame();
+  reader(static_cast<const Page&>(*guard));
+}
 
 }
@@ -0,0 +1,105 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "crc32c.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BADGERDB_CRC32C_SSE42
+#include <nmmintrin.h>
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Reversed Castagnoli polynomial.
+ */
+const std::uint32_t POLYNOMIAL = 0x82f63b78;
+
+/**
+ * Table for the byte-at-a-time software implementation.
+ */
+struct Crc32cTable {
+  std::uint32_t entries[256];
+
+  Crc32cTable() {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ ((crc & 1) ? POLYNOMIAL : 0);
+      }
+      entries[i] = crc;
+    }
+  }
+};
+
+std::uint32_t crc32cSoftware(std::uint32_t crc, const unsigned char* p,
+                             std::size_t length) {
+  static const Crc32cTable table;
+  for (; length > 0; --length) {
+    crc = table.entries[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#ifdef BADGERDB_CRC32C_SSE42
+__attribute__((target("sse4.2")))
+std::uint32_t crc32cHardware(std::uint32_t crc, const unsigned char* p,
+                             std::size_t length) {
+#if defined(__x86_64__)
+  std::uint64_t crc64 = crc;
+  for (; length >= 8; length -= 8, p += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  crc = static_cast<std::uint32_t>(crc64);
+#endif
+  for (; length >= 4; length -= 4, p += 4) {
+    std::uint32_t word;
+    std::memcpy(&word, p, sizeof(word));
+    crc = _mm_crc32_u32(crc, word);
+  }
+  for (; length > 0; --length) {
+    crc = _mm_crc32_u8(crc, *p++);
+  }
+  return crc;
+}
+#endif
+
+}
+
+std::uint32_t crc32c(const std::uint32_t crc, const char* data,
+                     const std::size_t length) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+#ifdef BADGERDB_CRC32C_SSE42
+  static const bool has_sse42 = crc32cAccelerated();
+  if (has_sse42) {
+    return ~crc32cHardware(~crc, p, length);
+  }
+#endif
+  return ~crc32cSoftware(~crc, p, length);
+}
+
+std::uint32_t crc32cTable(const std::uint32_t crc, const char* data,
+                          const std::size_t length) {
+  return ~crc32cSoftware(~crc, reinterpret_cast<const unsigned char*>(data),
+                         length);
+}
+
+bool crc32cAccelerated() {
+#ifdef BADGERDB_CRC32C_SSE42
+  return __builtin_cpu_supports("sse4.2");
+#else
+  return false;
+#endif
+}
+
+}
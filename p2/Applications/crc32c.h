@@ -0,0 +1,43 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * Extends a CRC32C (Castagnoli) checksum with more bytes.  Start with a crc
+ * of 0; checksumming a buffer in pieces gives the same result as
+ * checksumming it at once.
+ *
+ * Uses the SSE4.2 crc32 instruction when the CPU supports it, and a table
+ * driven implementation otherwise.
+ *
+ * @param crc     Checksum of the bytes so far.
+ * @param data    Bytes to add.
+ * @param length  Number of bytes to add.
+ * @return  Checksum including the new bytes.
+ */
+std::uint32_t crc32c(const std::uint32_t crc, const char* data,
+                     const std::size_t length);
+
+/**
+ * Same as crc32c() but always uses the table driven implementation, so that
+ * it can be compared with the instruction.
+ */
+std::uint32_t crc32cTable(const std::uint32_t crc, const char* data,
+                          const std::size_t length);
+
+/**
+ * Returns true if crc32c() uses the SSE4.2 crc32 instruction on this CPU.
+ */
+bool crc32cAccelerated();
+
+}
@@ -0,0 +1,191 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "dict_page.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_record_exception.h"
+#include "exceptions/invalid_record_length_exception.h"
+
+namespace badgerdb {
+
+DictPage::DictPage(Page* page, const std::size_t num_fields)
+    : page_(page),
+      num_fields_(num_fields) {
+  assert(page_ != NULL);
+  for (SlotId slot = page_->getNextUsedSlot(0, PAGE_FORMAT_DICT);
+       slot != Page::INVALID_SLOT;
+       slot = page_->getNextUsedSlot(slot, PAGE_FORMAT_DICT)) {
+    const RecordView encoded =
+        page_->getRecordView({page_->page_number(), slot}, PAGE_FORMAT_DICT);
+    if (encoded.length > 0 && encoded.data[0] == ENTRY_TAG) {
+      codes_[std::string(encoded.data + 1, encoded.length - 1)] = slot;
+      continue;
+    }
+    // A record written with another number of fields would be decoded past
+    // its end.
+    if (encoded.length != encodedLength() || encoded.data[0] != RECORD_TAG) {
+      throw InvalidRecordLengthException(page_->page_number(),
+                                         encodedLength(), encoded.length);
+    }
+    for (std::size_t field = 0; field < num_fields_; ++field) {
+      ++ref_counts_[fieldCode(encoded, field)];
+    }
+  }
+}
+
+void DictPage::initialize() {
+  const PageId page_number = page_->page_number();
+  const PageId next_page_number = page_->next_page_number();
+  page_->initialize();
+  page_->set_page_number(page_number);
+  page_->set_next_page_number(next_page_number);
+  page_->header_.format = PAGE_FORMAT_DICT;
+  codes_.clear();
+  ref_counts_.clear();
+}
+
+RecordId DictPage::insertRecord(const std::vector<std::string>& fields) {
+  page_->checkFormat(PAGE_FORMAT_DICT);
+  if (fields.size() != num_fields_) {
+    throw InvalidRecordLengthException(page_->page_number(), num_fields_,
+                                       fields.size());
+  }
+
+  // Check up front that the record and every new entry fit, so a failed
+  // insert leaves no orphaned entries behind.  Each may need a new slot.
+  std::size_t needed = encodedLength() + sizeof(PageSlot);
+  std::map<std::string, SlotId> new_values;
+  for (std::size_t field = 0; field < num_fields_; ++field) {
+    if (codes_.find(fields[field]) == codes_.end() &&
+        new_values.insert(std::make_pair(fields[field], 0)).second) {
+      needed += 1 + fields[field].length() + sizeof(PageSlot);
+    }
+  }
+  if (needed > page_->getFreeSpace()) {
+    throw InsufficientSpaceException(page_->page_number(), needed,
+                                     page_->getFreeSpace());
+  }
+
+  std::string encoded(encodedLength(), RECORD_TAG);
+  for (std::size_t field = 0; field < num_fields_; ++field) {
+    std::map<std::string, SlotId>::const_iterator entry =
+        codes_.find(fields[field]);
+    if (entry == codes_.end()) {
+      const RecordId entry_id = page_->insertRecord(
+          std::string(1, ENTRY_TAG) + fields[field], PAGE_FORMAT_DICT);
+      entry = codes_.insert(
+          std::make_pair(fields[field], entry_id.slot_number)).first;
+    }
+    ++ref_counts_[entry->second];
+    std::memcpy(&encoded[1 + field * sizeof(SlotId)], &entry->second,
+                sizeof(SlotId));
+  }
+  return page_->insertRecord(encoded, PAGE_FORMAT_DICT);
+}
+
+std::vector<std::string> DictPage::getRecord(const RecordId& record_id) const {
+  const RecordView encoded = getEncoded(record_id);
+  std::vector<std::string> fields;
+  fields.reserve(num_fields_);
+  for (std::size_t field = 0; field < num_fields_; ++field) {
+    const RecordView entry = page_->getRecordView(
+        {page_->page_number(), fieldCode(encoded, field)}, PAGE_FORMAT_DICT);
+    fields.push_back(std::string(entry.data + 1, entry.length - 1));
+  }
+  return fields;
+}
+
+RecordView DictPage::getField(const RecordId& record_id,
+                              const std::size_t field) const {
+  assert(field < num_fields_);
+  const RecordView entry = page_->getRecordView(
+      {page_->page_number(), fieldCode(getEncoded(record_id), field)},
+      PAGE_FORMAT_DICT);
+  RecordView view = {entry.data + 1, entry.length - 1};
+  return view;
+}
+
+void DictPage::deleteRecord(const RecordId& record_id) {
+  const RecordView encoded = getEncoded(record_id);
+  std::vector<SlotId> codes(num_fields_);
+  for (std::size_t field = 0; field < num_fields_; ++field) {
+    codes[field] = fieldCode(encoded, field);
+  }
+  page_->deleteRecord(record_id, PAGE_FORMAT_DICT);
+
+  for (std::size_t field = 0; field < num_fields_; ++field) {
+    if (--ref_counts_[codes[field]] > 0) {
+      continue;
+    }
+    ref_counts_.erase(codes[field]);
+    const RecordId entry_id = {page_->page_number(), codes[field]};
+    const RecordView entry = page_->getRecordView(entry_id, PAGE_FORMAT_DICT);
+    codes_.erase(std::string(entry.data + 1, entry.length - 1));
+    page_->deleteRecord(entry_id, PAGE_FORMAT_DICT);
+  }
+}
+
+bool DictPage::lookupCode(const std::string& value, SlotId& code) const {
+  page_->checkFormat(PAGE_FORMAT_DICT);
+  const std::map<std::string, SlotId>::const_iterator entry =
+      codes_.find(value);
+  if (entry == codes_.end()) {
+    return false;
+  }
+  code = entry->second;
+  return true;
+}
+
+void DictPage::findEqual(const std::size_t field, const std::string& value,
+                         std::vector<RecordId>& matches) const {
+  assert(field < num_fields_);
+  SlotId code;
+  if (!lookupCode(value, code)) {
+    return;
+  }
+  for (SlotId slot = getNextRecordSlot(0); slot != Page::INVALID_SLOT;
+       slot = getNextRecordSlot(slot)) {
+    const RecordId record_id = {page_->page_number(), slot};
+    if (fieldCode(page_->getRecordView(record_id, PAGE_FORMAT_DICT), field) ==
+        code) {
+      matches.push_back(record_id);
+    }
+  }
+}
+
+SlotId DictPage::getNextRecordSlot(const SlotId start) const {
+  page_->checkFormat(PAGE_FORMAT_DICT);
+  SlotId slot = page_->getNextUsedSlot(start, PAGE_FORMAT_DICT);
+  while (slot != Page::INVALID_SLOT &&
+         page_->getRecordView({page_->page_number(), slot}, PAGE_FORMAT_DICT)
+                 .data[0] != RECORD_TAG) {
+    slot = page_->getNextUsedSlot(slot, PAGE_FORMAT_DICT);
+  }
+  return slot;
+}
+
+SlotId DictPage::fieldCode(const RecordView& encoded,
+                           const std::size_t field) {
+  SlotId code;
+  std::memcpy(&code, encoded.data + 1 + field * sizeof(SlotId), sizeof(code));
+  return code;
+}
+
+RecordView DictPage::getEncoded(const RecordId& record_id) const {
+  const RecordView encoded =
+      page_->getRecordView(record_id, PAGE_FORMAT_DICT);
+  if (encoded.length != encodedLength() || encoded.data[0] != RECORD_TAG) {
+    throw InvalidRecordException(record_id, page_->page_number());
+  }
+  return encoded;
+}
+
+}
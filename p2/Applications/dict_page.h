@@ -0,0 +1,200 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief View which stores dictionary-encoded records in a slotted Page.
+ *
+ * Each record is a fixed number of byte-string fields.  Every distinct field
+ * value is stored once on the page as a dictionary entry, and records store
+ * only the codes of their values.  A field's code is the slot number of its
+ * dictionary entry, so codes are two bytes and decoding is one slot lookup.
+ *
+ * Dictionary entries and encoded records are both kept in the page's slot
+ * array, told apart by a one-byte tag, so the page keeps working with File,
+ * BufMgr and checksums unchanged.  initialize() records PAGE_FORMAT_DICT in
+ * the page header, so the slotted Page API and file scans see no records on
+ * a dictionary page, and every other method throws PageFormatException on a
+ * page of another format.  Entries are dropped when the last record using
+ * them is deleted.
+ *
+ * Constructing a view reads the whole page to build the value-to-code map
+ * and reference counts, so create one view per pin and reuse it.
+ *
+ * @warning This class is not threadsafe.
+ */
+class DictPage {
+ public:
+  /**
+   * Constructs a dictionary view over the given page.  The page must outlive
+   * the view (typically it is pinned in the buffer pool), and must only be
+   * changed through this view while it exists.  A page of another format is
+   * seen as empty until initialize() is called.
+   *
+   * @param page        Page to view.
+   * @param num_fields  Number of fields in every record.
+   * @throws  InvalidRecordLengthException  If a record on the page does not
+   *                                        have num_fields fields.
+   */
+  DictPage(Page* page, const std::size_t num_fields);
+
+  /**
+   * Empties the page and formats it as a dictionary page, keeping its page
+   * number and link to the next page.
+   */
+  void initialize();
+
+  /**
+   * Inserts a new record into the page, adding dictionary entries for values
+   * not already on the page.
+   *
+   * @param fields  Field values; there must be num_fields() of them.
+   * @return  ID of the newly inserted record.
+   * @throws  InvalidRecordLengthException  If the number of fields is wrong.
+   * @throws  InsufficientSpaceException    If the page cannot hold the record
+   *                                        and its new entries.
+   */
+  RecordId insertRecord(const std::vector<std::string>& fields);
+
+  /**
+   * Returns the decoded fields of the record with the given ID.
+   *
+   * @param record_id  ID of the record to return.
+   * @return  Field values.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  std::vector<std::string> getRecord(const RecordId& record_id) const;
+
+  /**
+   * Returns a view of one decoded field of the record with the given ID.
+   *
+   * @param record_id  ID of the record.
+   * @param field      Field number.
+   * @return  View of the field value inside the page.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  RecordView getField(const RecordId& record_id,
+                      const std::size_t field) const;
+
+  /**
+   * Deletes the record with the given ID, and any dictionary entries no
+   * other record uses.
+   *
+   * @param record_id   ID of the record to delete.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  void deleteRecord(const RecordId& record_id);
+
+  /**
+   * Looks up the code of a value on this page.
+   *
+   * @param value  Value to look up.
+   * @param code   Set to the value's code if it is on the page.
+   * @return  False if no record on the page has this value.
+   */
+  bool lookupCode(const std::string& value, SlotId& code) const;
+
+  /**
+   * Appends the IDs of records whose field equals <value> to <matches>.  The
+   * value is translated to a code once and records are compared by code, so
+   * no field is decoded.
+   *
+   * @param field    Field number.
+   * @param value    Value to compare against.
+   * @param matches  Vector to append matching record IDs to.
+   */
+  void findEqual(const std::size_t field, const std::string& value,
+                 std::vector<RecordId>& matches) const;
+
+  /**
+   * Returns the next record slot after the given slot, skipping dictionary
+   * entries, or Page::INVALID_SLOT if there are no more records.
+   *
+   * @param start   Slot to start search at.
+   * @return  Next record slot after given slot or Page::INVALID_SLOT.
+   */
+  SlotId getNextRecordSlot(const SlotId start) const;
+
+  /**
+   * Returns the number of fields in every record.
+   */
+  std::size_t num_fields() const { return num_fields_; }
+
+  /**
+   * Returns the number of distinct values stored on the page.
+   */
+  std::size_t num_entries() const { return codes_.size(); }
+
+ private:
+  /**
+   * Tag byte that starts every dictionary entry.
+   */
+  static const char ENTRY_TAG = 'D';
+
+  /**
+   * Tag byte that starts every encoded record.
+   */
+  static const char RECORD_TAG = 'R';
+
+  /**
+   * Returns the code of the given field of an encoded record.
+   *
+   * @param encoded  View of the encoded record.
+   * @param field    Field number.
+   * @return  Code of the field value.
+   */
+  static SlotId fieldCode(const RecordView& encoded, const std::size_t field);
+
+  /**
+   * Returns the length of every encoded record: its tag and one code per
+   * field.
+   */
+  std::size_t encodedLength() const {
+    return 1 + num_fields_ * sizeof(SlotId);
+  }
+
+  /**
+   * Returns a view of the encoded record with the given ID.
+   *
+   * @param record_id  ID of the record.
+   * @return  View of the encoded record.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  RecordView getEncoded(const RecordId& record_id) const;
+
+  /**
+   * Page being viewed.
+   */
+  Page* page_;
+
+  /**
+   * Number of fields in every record.
+   */
+  std::size_t num_fields_;
+
+  /**
+   * Code of every value on the page.
+   */
+  std::map<std::string, SlotId> codes_;
+
+  /**
+   * Number of records referencing each code.
+   */
+  std::map<SlotId, std::size_t> ref_counts_;
+};
+
+}
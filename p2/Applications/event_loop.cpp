@@ -0,0 +1,92 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "event_loop.h"
+
+#include <memory>
+
+namespace badgerdb {
+
+EventLoop::EventLoop(TaskScheduler& io) : io_(io), in_flight_(0) {}
+
+EventLoop::~EventLoop() { io_.wait(io_group_); }
+
+void EventLoop::post(std::function<void()> callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ready_.push_back(std::move(callback));
+  changed_.notify_one();
+}
+
+void EventLoop::offload(std::function<void()> blocking,
+                        std::function<void(std::exception_ptr)> resume) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++in_flight_;
+  }
+  io_.spawn(io_group_, [this, blocking, resume]() {
+    std::exception_ptr error;
+    try {
+      blocking();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    // Notify under the lock: once in_flight_ drops the loop may return and
+    // its owner destroy it.
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.push_back([resume, error]() { resume(error); });
+    --in_flight_;
+    changed_.notify_one();
+  });
+}
+
+void EventLoop::run() {
+  while (true) {
+    std::function<void()> callback;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      changed_.wait(lock,
+                    [this]() { return !ready_.empty() || in_flight_ == 0; });
+      if (ready_.empty()) {
+        return;
+      }
+      callback = std::move(ready_.front());
+      ready_.pop_front();
+    }
+    callback();
+  }
+}
+
+void readPageAsync(EventLoop& loop, BufMgr* buf_mgr, File* file,
+                   const PageId page_number, const LatchMode mode,
+                   const PageCallback& then) {
+  // Callbacks must be copyable, so the move-only guard travels in a
+  // shared holder.
+  const std::shared_ptr<PageGuard> page = std::make_shared<PageGuard>(
+      buf_mgr->tryReadPage(file, page_number, mode));
+  if (*page && page->mode() == mode) {
+    loop.post([page, then]() { then(std::move(*page), nullptr); });
+    return;
+  }
+  // The latch may be held by another lookup on this loop, which can only
+  // release it if the loop keeps running.
+  if (*page) {
+    loop.offload([page, mode]() { page->latch(mode); },
+                 [page, then](std::exception_ptr error) {
+                   then(std::move(*page), error);
+                 });
+    return;
+  }
+  loop.offload(
+      [page, buf_mgr, file, page_number, mode]() {
+        *page = buf_mgr->readPage(file, page_number, mode);
+      },
+      [page, then](std::exception_ptr error) {
+        then(std::move(*page), error);
+      });
+}
+
+}
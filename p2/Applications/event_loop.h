@@ -0,0 +1,124 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+#include "buffer.h"
+#include "file.h"
+#include "task_scheduler.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Single-threaded loop running callbacks, with blocking work moved to
+ * a TaskScheduler.
+ *
+ * One thread calls run() and executes callbacks one at a time as they become
+ * ready.  Work that would block, such as reading a page from disk, is handed
+ * to the scheduler's workers with offload(); when it finishes, its
+ * continuation is queued back on the loop.  A single loop thread can thus
+ * keep many lookups in flight, each written as a chain of callbacks.
+ */
+class EventLoop {
+ public:
+  /**
+   * @param io  Scheduler whose workers run offloaded work.
+   */
+  explicit EventLoop(TaskScheduler& io);
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  /**
+   * Waits for offloaded work still running.  Callbacks that have not run
+   * are dropped.
+   */
+  ~EventLoop();
+
+  /**
+   * Queues a callback to run on the loop.  May be called from any thread.
+   *
+   * @param callback  Work to run.
+   */
+  void post(std::function<void()> callback);
+
+  /**
+   * Runs <blocking> on a worker of the scheduler and then <resume> on the
+   * loop, passing it the exception <blocking> threw, if any.
+   *
+   * @param blocking  Work that may block.
+   * @param resume    Continuation run on the loop.
+   */
+  void offload(std::function<void()> blocking,
+               std::function<void(std::exception_ptr)> resume);
+
+  /**
+   * Runs callbacks until none is queued and no offloaded work is left.
+   * An exception thrown by a callback stops the loop and propagates; run()
+   * may be called again to continue.
+   */
+  void run();
+
+ private:
+  TaskScheduler& io_;
+
+  /**
+   * Offloaded work that has not finished, waited for by the destructor.
+   */
+  TaskGroup io_group_;
+
+  /**
+   * Callbacks ready to run.
+   */
+  std::deque<std::function<void()> > ready_;
+
+  /**
+   * Number of offloaded pieces of work whose continuation is not queued yet.
+   */
+  std::uint32_t in_flight_;
+
+  /**
+   * Lock protecting ready_ and in_flight_, and the condition run() sleeps on
+   * until one of them changes.
+   */
+  std::mutex mutex_;
+  std::condition_variable changed_;
+};
+
+/**
+ * Called on the loop with a page read by readPageAsync(), or with an empty
+ * guard and the exception the read threw.
+ */
+typedef std::function<void(PageGuard page, std::exception_ptr error)>
+    PageCallback;
+
+/**
+ * Reads a page without blocking the loop's thread on I/O.  A page in the
+ * buffer pool is pinned and latched at once; a miss is read in by a worker of
+ * the loop's scheduler.  Either way <then> runs later on the loop.  The loop
+ * thread never waits for a latch either: a cached page whose latch is busy
+ * stays pinned while a worker waits for the latch.
+ *
+ * @param loop       Loop <then> runs on.
+ * @param buf_mgr    Buffer manager to read the page through.
+ * @param file       File holding the page.
+ * @param page_number  Number of the page to read.
+ * @param mode       Mode in which to latch the page.
+ * @param then       Continuation receiving the page.
+ */
+void readPageAsync(EventLoop& loop, BufMgr* buf_mgr, File* file,
+                   const PageId page_number, const LatchMode mode,
+                   const PageCallback& then);
+
+}
@@ -0,0 +1,31 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "corrupt_page_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+CorruptPageException::CorruptPageException(
+    const PageId page_num, const std::string& file,
+    const std::uint32_t stored, const std::uint32_t computed)
+    : BadgerDbException(""),
+      page_number_(page_num),
+      filename_(file),
+      stored_checksum_(stored),
+      computed_checksum_(computed) {
+  std::stringstream ss;
+  ss << "Page " << page_number_ << " of file '" << filename_
+     << "' failed checksum verification."
+     << " Stored: " << std::hex << stored_checksum_
+     << " Computed: " << computed_checksum_;
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,76 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page read from disk does not
+ *        match the checksum stored in its header.
+ *
+ * This means the page was torn by an interrupted write or corrupted on disk.
+ */
+class CorruptPageException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a corrupt page exception for the given page and file.
+   *
+   * @param page_num  Number of page that failed verification.
+   * @param file      Name of file the page was read from.
+   * @param stored    Checksum stored in the page header.
+   * @param computed  Checksum computed over the page contents.
+   */
+  CorruptPageException(const PageId page_num, const std::string& file,
+                       const std::uint32_t stored,
+                       const std::uint32_t computed);
+
+  /**
+   * Destroys the exception.  Does nothing special; just included to make the
+   * compiler happy.
+   */
+  virtual ~CorruptPageException() throw() {}
+
+  /**
+   * Returns the number of the page that caused this exception.
+   */
+  virtual PageId page_number() const { return page_number_; }
+
+  /**
+   * Returns name of the file that caused this exception.
+   */
+  virtual const std::string& filename() const { return filename_; }
+
+ protected:
+  /**
+   * Number of page that failed verification.
+   */
+  const PageId page_number_;
+
+  /**
+   * Name of file the page was read from.
+   */
+  const std::string filename_;
+
+  /**
+   * Checksum stored in the page header.
+   */
+  const std::uint32_t stored_checksum_;
+
+  /**
+   * Checksum computed over the page contents.
+   */
+  const std::uint32_t computed_checksum_;
+};
+
+}
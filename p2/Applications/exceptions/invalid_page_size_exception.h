@@ -0,0 +1,65 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a file's page size is not
+ *        supported where it is used.
+ *
+ * This happens when a file is created with a page size that is not a power of
+ * two between Page::MIN_SIZE and Page::MAX_SIZE, when an existing file's
+ * header records such a size, or when a file's pages are larger than the
+ * frames of the buffer pool they are read into.
+ */
+class InvalidPageSizeException : public BadgerDbException {
+ public:
+  /**
+   * Constructs an invalid page size exception for the given size and file.
+   *
+   * @param page_size  Offending page size in bytes.
+   * @param file       Name of file with that page size.
+   */
+  InvalidPageSizeException(const std::size_t page_size,
+                           const std::string& file);
+
+  /**
+   * Destroys the exception.  Does nothing special; just included to make the
+   * compiler happy.
+   */
+  virtual ~InvalidPageSizeException() throw() {}
+
+  /**
+   * Returns the page size that caused this exception.
+   */
+  virtual std::size_t page_size() const { return page_size_; }
+
+  /**
+   * Returns name of the file that caused this exception.
+   */
+  virtual const std::string& filename() const { return filename_; }
+
+ protected:
+  /**
+   * Page size which caused this exception.
+   */
+  const std::size_t page_size_;
+
+  /**
+   * Name of file which caused this exception.
+   */
+  const std::string filename_;
+};
+
+}
@@ -0,0 +1,29 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "invalid_record_length_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+InvalidRecordLengthException::InvalidRecordLengthException(
+    const PageId page_num, const std::size_t expected,
+    const std::size_t actual)
+    : BadgerDbException(""),
+      page_number_(page_num),
+      expected_length_(expected),
+      actual_length_(actual) {
+  std::stringstream ss;
+  ss << "Record length does not match the record length of page "
+     << page_number_ << ".  Expected: " << expected_length_ << " bytes."
+     << " Actual: " << actual_length_ << " bytes.";
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,66 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a record's length does not match
+ *        the fixed record length required by a page format.
+ */
+class InvalidRecordLengthException : public BadgerDbException {
+ public:
+  /**
+   * Constructs an invalid record length exception for the given page.
+   *
+   * @param page_num    Number of page the record was destined for.
+   * @param expected    Record length required by the page in bytes.
+   * @param actual      Length of the offending record in bytes.
+   */
+  InvalidRecordLengthException(const PageId page_num,
+                               const std::size_t expected,
+                               const std::size_t actual);
+
+  /**
+   * Returns the page number of the page that caused this exception.
+   */
+  PageId page_number() const { return page_number_; }
+
+  /**
+   * Returns the record length required by the page in bytes.
+   */
+  std::size_t expected_length() const { return expected_length_; }
+
+  /**
+   * Returns the length of the offending record in bytes.
+   */
+  std::size_t actual_length() const { return actual_length_; }
+
+ protected:
+  /**
+   * Page number of the page that caused this exception.
+   */
+  const PageId page_number_;
+
+  /**
+   * Record length required by the page.
+   */
+  const std::size_t expected_length_;
+
+  /**
+   * Length of the offending record.
+   */
+  const std::size_t actual_length_;
+};
+
+}
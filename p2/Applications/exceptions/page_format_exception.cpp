@@ -0,0 +1,28 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "page_format_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+PageFormatException::PageFormatException(const PageId page_num,
+                                         const std::uint16_t expected,
+                                         const std::uint16_t found)
+    : BadgerDbException(""),
+      page_number_(page_num),
+      expected_(expected),
+      found_(found) {
+  std::stringstream ss;
+  ss << "Page " << page_number_ << " has format " << found_
+     << " but was used as format " << expected_;
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,74 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page is used with a layout other
+ *        than the one recorded in its header.
+ *
+ * For example, reading a PAX page through the slotted page API, or viewing
+ * a slotted page as a PAX page.
+ */
+class PageFormatException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a page format exception for the given page.
+   *
+   * @param page_num  Number of page that was used.
+   * @param expected  Format the caller expected (a PageFormat).
+   * @param found     Format recorded in the page header.
+   */
+  PageFormatException(const PageId page_num, const std::uint16_t expected,
+                      const std::uint16_t found);
+
+  /**
+   * Destroys the exception.  Does nothing special; just included to make the
+   * compiler happy.
+   */
+  virtual ~PageFormatException() throw() {}
+
+  /**
+   * Returns the number of the page that caused this exception.
+   */
+  virtual PageId page_number() const { return page_number_; }
+
+  /**
+   * Returns the format the caller expected.
+   */
+  virtual std::uint16_t expected() const { return expected_; }
+
+  /**
+   * Returns the format recorded in the page header.
+   */
+  virtual std::uint16_t found() const { return found_; }
+
+ protected:
+  /**
+   * Number of page which caused this exception.
+   */
+  const PageId page_number_;
+
+  /**
+   * Format the caller expected.
+   */
+  const std::uint16_t expected_;
+
+  /**
+   * Format recorded in the page header.
+   */
+  const std::uint16_t found_;
+};
+
+}
@@ -14,24 +14,36 @@
 #include <cstdio>
 #include <cassert>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "crc32c.h"
+#include "exceptions/corrupt_page_exception.h"
 #include "exceptions/file_exists_exception.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/file_open_exception.h"
 #include "exceptions/invalid_page_exception.h"
+#include "exceptions/invalid_page_size_exception.h"
 #include "file_iterator.h"
+#include "lz_codec.h"
 #include "page.h"
 
 namespace badgerdb {
 
 File::StreamMap File::open_streams_;
 File::CountMap File::open_counts_;
+File::DescriptorMap File::open_descriptors_;
 
-File File::create(const std::string& filename) {
-  return File(filename, true /* create_new */);
+File File::create(const std::string& filename, const bool compress_pages,
+                  const std::size_t page_size) {
+  return File(filename, true /* create_new */, compress_pages, page_size);
 }
 
 File File::open(const std::string& filename) {
-  return File(filename, false /* create_new */);
+  return File(filename, false /* create_new */, false /* compress_pages */,
+              Page::DEFAULT_SIZE);
 }
 
 void File::remove(const std::string& filename) {
@@ -64,7 +76,9 @@ bool File::exists(const std::string& filename) {
 
 File::File(const File& other)
   : filename_(other.filename_),
-    stream_(open_streams_[filename_]) {
+    stream_(open_streams_[filename_]),
+    compressed_(other.compressed_),
+    page_size_(other.page_size_) {
   ++open_counts_[filename_];
 }
 
@@ -74,6 +88,8 @@ File& File::operator=(const File& rhs) {
   close();	//close my file and associate me with the new one
   filename_ = rhs.filename_;
   openIfNeeded(false /* create_new */);
+  compressed_ = rhs.compressed_;
+  page_size_ = rhs.page_size_;
   return *this;
 }
 
@@ -83,8 +99,8 @@ File::~File() {
 
 Page File::allocatePage() {
   FileHeader header = readHeader();
-  Page new_page;
-  Page existing_page;
+  Page new_page(page_size_);
+  Page existing_page(page_size_);
   if (header.num_free_pages > 0) {
     new_page = readPage(header.first_free_page, true /* allow_free */);
     new_page.set_page_number(header.first_free_page);
@@ -154,19 +170,46 @@ Page File::readPage(const PageId page_number) const {
   return readPage(page_number, false /* allow_free */);
 }
 
+void File::readPage(const PageId page_number, Page& page) const {
+  FileHeader header = readHeader();
+  if (page_number >= header.num_pages) {
+    throw InvalidPageException(page_number, filename_);
+  }
+  readPage(page_number, false /* allow_free */, page);
+}
+
 Page File::readPage(const PageId page_number, const bool allow_free) const {
-  Page page;
+  Page page(page_size_);
+  readPage(page_number, allow_free, page);
+  return page;
+}
+
+void File::readPage(const PageId page_number, const bool allow_free,
+                    Page& page) const {
+  page.setSize(page_size_);
   stream_->seekg(pagePosition(page_number), std::ios::beg);
   stream_->read(reinterpret_cast<char*>(&page.header_), sizeof(page.header_));
-  stream_->read(&page.data_[0], Page::DATA_SIZE);
+  if (compressed_) {
+    readCompressedData(page_number, page);
+  } else {
+    stream_->read(&page.data_[0], page.data_size());
+  }
+  // The header is only trusted once the checksum matches.
+  const std::uint32_t checksum = pageChecksum(page.header_, page);
+  if (checksum != page.header_.checksum) {
+    throw CorruptPageException(page_number, filename_, page.header_.checksum,
+                               checksum);
+  }
+  page.rebuildSlotMap();
   if (!allow_free && !page.isUsed()) {
     throw InvalidPageException(page_number, filename_);
   }
-
-  return page;
 }
 
 void File::writePage(const Page& new_page) {
+  if (new_page.size() != page_size_) {
+    throw InvalidPageSizeException(new_page.size(), filename_);
+  }
   PageHeader header = readPageHeader(new_page.page_number());
   if (header.current_page_number == Page::INVALID_NUMBER) {
     // Page has been deleted since it was read.
@@ -184,7 +227,7 @@ void File::writePage(const Page& new_page) {
 void File::deletePage(const PageId page_number) {
   FileHeader header = readHeader();
   Page existing_page = readPage(page_number);
-  Page previous_page;
+  Page previous_page(page_size_);
   // If this page is the head of the used list, update the header to point to
   // the next page in line.
   if (page_number == header.first_used_page) {
@@ -220,14 +263,32 @@ FileIterator File::end() {
   return FileIterator(this, Page::INVALID_NUMBER);
 }
 
-File::File(const std::string& name, const bool create_new) : filename_(name) {
+File::File(const std::string& name, const bool create_new,
+           const bool compress_pages, const std::size_t page_size)
+    : filename_(name),
+      compressed_(compress_pages),
+      page_size_(page_size) {
+  if (create_new && !Page::isValidSize(page_size)) {
+    throw InvalidPageSizeException(page_size, filename_);
+  }
   openIfNeeded(create_new);
 
   if (create_new) {
     // File starts with 1 page (the header).
     FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
-                         0 /* num_free_pages */, 0 /* first_free_page */};
+                         0 /* num_free_pages */, 0 /* first_free_page */,
+                         compress_pages ? FileHeader::COMPRESSED_PAGES : 0,
+                         static_cast<std::uint32_t>(page_size)};
     writeHeader(header);
+  } else {
+    const FileHeader header = readHeader();
+    compressed_ = (header.flags & FileHeader::COMPRESSED_PAGES) != 0;
+    page_size_ = header.page_size;
+    if (!Page::isValidSize(page_size_)) {
+      // The destructor does not run for a constructor that throws.
+      close();
+      throw InvalidPageSizeException(page_size_, filename_);
+    }
   }
 }
 
@@ -255,6 +316,11 @@ void File::openIfNeeded(const bool create_new) {
     stream_.reset(new std::fstream(filename_, mode));
     open_streams_[filename_] = stream_;
     open_counts_[filename_] = 1;
+#ifdef __linux__
+    open_descriptors_[filename_] = ::open(filename_.c_str(), O_WRONLY);
+#else
+    open_descriptors_[filename_] = -1;
+#endif
   }
 }
 
@@ -262,6 +328,12 @@ void File::close() {
   --open_counts_[filename_];
   stream_.reset();
   if (open_counts_[filename_] == 0) {
+#ifdef __linux__
+    if (open_descriptors_[filename_] >= 0) {
+      ::close(open_descriptors_[filename_]);
+    }
+#endif
+    open_descriptors_.erase(filename_);
     open_streams_.erase(filename_);
     open_counts_.erase(filename_);
   }
@@ -271,12 +343,121 @@ void File::writePage(const PageId page_number, const Page& new_page) {
   writePage(page_number, new_page.header_, new_page);
 }
 
-void File::writePage(const PageId page_number, const PageHeader& header,
+void File::writePage(const PageId page_number, const PageHeader& page_header,
                      const Page& new_page) {
+  PageHeader header = page_header;
+  header.checksum = pageChecksum(header, new_page);
   stream_->seekp(pagePosition(page_number), std::ios::beg);
   stream_->write(reinterpret_cast<const char*>(&header), sizeof(header));
-  stream_->write(&new_page.data_[0], Page::DATA_SIZE);
-  stream_->flush();
+  if (compressed_) {
+    const std::size_t written = writeCompressedData(header, new_page);
+    stream_->flush();
+    releaseSlack(page_number, sizeof(header) + written);
+  } else {
+    stream_->write(&new_page.data_[0], new_page.data_size());
+    stream_->flush();
+  }
+}
+
+std::size_t File::writeCompressedData(const PageHeader& header,
+                                      const Page& new_page) {
+  // Everything but the free space between the slot array and the records.
+  const std::size_t lower = header.free_space_lower_bound;
+  const std::size_t upper = header.free_space_upper_bound;
+  const std::size_t data_size = new_page.data_size();
+  std::string image;
+  image.reserve(data_size - (upper - lower));
+  image.append(new_page.data_, 0, lower);
+  image.append(new_page.data_, upper, data_size - upper);
+
+  // Fall back to the raw image if it does not compress to fewer bytes;
+  // readers tell the two apart by the stored length, so a compressed image
+  // must be strictly shorter than the raw one.
+  std::string stored(image.length(), '\0');
+  std::uint32_t stored_length = 0;
+  if (image.length() > 1) {
+    stored_length = lzCompress(image.data(), image.length(),
+                               &stored[0], image.length() - 1);
+  }
+  if (stored_length == 0) {
+    stored.swap(image);
+    stored_length = stored.length();
+  }
+  stream_->write(reinterpret_cast<const char*>(&stored_length),
+                 sizeof(stored_length));
+  stream_->write(stored.data(), stored_length);
+  return sizeof(stored_length) + stored_length;
+}
+
+void File::releaseSlack(const PageId page_number, const std::size_t used) {
+#ifdef __linux__
+  const int fd = open_descriptors_[filename_];
+  if (fd < 0 || used >= page_size_) {
+    return;
+  }
+  // Failure (e.g. EOPNOTSUPP) only means the space is not reclaimed.
+  const off_t position = static_cast<off_t>(pagePosition(page_number));
+  ::fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+              position + used, page_size_ - used);
+#else
+  (void)page_number;
+  (void)used;
+#endif
+}
+
+void File::readCompressedData(const PageId page_number, Page& page) const {
+  const std::size_t lower = page.header_.free_space_lower_bound;
+  const std::size_t upper = page.header_.free_space_upper_bound;
+  const std::size_t data_size = page.data_size();
+  std::uint32_t stored_length = 0;
+  stream_->read(reinterpret_cast<char*>(&stored_length),
+                sizeof(stored_length));
+  if (lower > upper || upper > data_size) {
+    throw InvalidPageException(page_number, filename_);
+  }
+  const std::size_t image_length = data_size - (upper - lower);
+  if (stored_length > image_length) {
+    throw InvalidPageException(page_number, filename_);
+  }
+  std::string stored(stored_length, '\0');
+  stream_->read(&stored[0], stored_length);
+
+  // The free space is not stored; clear what the page held before.
+  page.data_.replace(lower, upper - lower, upper - lower, '\0');
+  std::string image;
+  if (stored_length == image_length) {
+    image.swap(stored);
+  } else {
+    image.assign(image_length, '\0');
+    if (!lzDecompress(stored.data(), stored.length(), &image[0],
+                      image_length)) {
+      throw InvalidPageException(page_number, filename_);
+    }
+  }
+  page.data_.replace(0, lower, image, 0, lower);
+  page.data_.replace(upper, data_size - upper, image, lower,
+                     image_length - lower);
+}
+
+std::uint32_t File::pageChecksum(const PageHeader& header,
+                                 const Page& page) {
+  PageHeader unsummed_header = header;
+  unsummed_header.checksum = 0;
+  std::uint32_t checksum = crc32c(
+      0, reinterpret_cast<const char*>(&unsummed_header),
+      sizeof(unsummed_header));
+  // The free space may hold stale bytes (and is not stored at all in
+  // compressed files), so it is left out.
+  const std::size_t lower = header.free_space_lower_bound;
+  const std::size_t upper = header.free_space_upper_bound;
+  const std::size_t data_size = page.data_size();
+  if (lower <= upper && upper <= data_size) {
+    checksum = crc32c(checksum, page.data_.data(), lower);
+    checksum = crc32c(checksum, page.data_.data() + upper, data_size - upper);
+  } else {
+    checksum = crc32c(checksum, page.data_.data(), data_size);
+  }
+  return checksum;
 }
 
 FileHeader File::readHeader() const {
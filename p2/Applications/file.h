@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <fstream>
 #include <string>
 #include <map>
@@ -42,6 +43,21 @@ struct FileHeader {
    */
   PageId first_free_page;
 
+  /**
+   * Bit flags describing how pages are stored on disk.
+   */
+  std::uint32_t flags;
+
+  /**
+   * Size in bytes of every page in the file.
+   */
+  std::uint32_t page_size;
+
+  /**
+   * Flag set if page images are stored compressed.
+   */
+  static const std::uint32_t COMPRESSED_PAGES = 1;
+
   /**
    * Returns true if this file header is equal to the other.
    *
@@ -52,7 +68,9 @@ struct FileHeader {
     return num_pages == rhs.num_pages &&
         num_free_pages == rhs.num_free_pages &&
         first_used_page == rhs.first_used_page &&
-        first_free_page == rhs.first_free_page;
+        first_free_page == rhs.first_free_page &&
+        flags == rhs.flags &&
+        page_size == rhs.page_size;
   }
 };
 
@@ -61,7 +79,8 @@ struct FileHeader {
  *        pages.
  *
  * The File class wraps a stream to an underlying file on disk.  Files contain
- * fixed-sized pages, and they never deallocate space (though they do reuse
+ * fixed-sized pages, whose size is chosen when the file is created and
+ * recorded in its header, and they never deallocate space (though they do reuse
  * deleted pages if possible).  If multiple File objects refer to the same
  * underlying file, they will share the stream in memory.
  * If a file that has already been opened (possibly by another query), then the File class
@@ -75,10 +94,33 @@ class File {
   /**
    * Creates a new file.
    *
-   * @param filename  Name of the file.
-   * @throws  FileExistsException     If the requested file already exists.
+   * If <compress_pages> is set, every page image is compressed when written
+   * and decompressed when read, and the free space in the middle of a page
+   * is not stored at all.  Pages in memory are unaffected.  The setting is
+   * recorded in the file and applies whenever the file is opened.
+   *
+   * Compressed pages keep their fixed-size place in the file, so page
+   * positions need no map, and I/O shrinks to the compressed images.  The
+   * rest of each page's place is released with hole punching on Linux
+   * (fallocate with FALLOC_FL_PUNCH_HOLE), which shrinks the disk footprint
+   * on filesystems that support it (ext4, XFS, Btrfs, tmpfs) in whole
+   * filesystem blocks, so pages larger than a block gain the most.  Elsewhere the
+   * file keeps its full size on disk.
+   *
+   * Every page of the file is <page_size> bytes long, so a file can be
+   * tuned for its workload: large pages for tables that are mostly scanned,
+   * small pages for point lookups.
+   *
+   * @param filename        Name of the file.
+   * @param compress_pages  Whether to store page images compressed.
+   * @param page_size       Size of the file's pages in bytes.
+   * @throws  FileExistsException       If the requested file already exists.
+   * @throws  InvalidPageSizeException  If the page size is not supported (see
+   *                                    Page::isValidSize()).
    */
-  static File create(const std::string& filename);
+  static File create(const std::string& filename,
+                     const bool compress_pages = false,
+                     const std::size_t page_size = Page::DEFAULT_SIZE);
 
   /**
    * Opens the file named fileName and returns the corresponding File object.
@@ -88,7 +130,9 @@ class File {
 	 * open_streams_ map.
    *
    * @param filename  Name of the file.
-   * @throws  FileNotFoundException   If the requested file doesn't exist.
+   * @throws  FileNotFoundException     If the requested file doesn't exist.
+   * @throws  InvalidPageSizeException  If the file header records an
+   *                                    unsupported page size.
    */
   static File open(const std::string& filename);
 
@@ -152,15 +196,33 @@ class File {
    * @return  The page.
    * @throws  InvalidPageException  If the page doesn't exist in the file or is
    *                                not currently used.
+   * @throws  CorruptPageException  If the page fails checksum verification.
    */
   Page readPage(const PageId page_number) const;
 
+  /**
+   * Reads an existing page from the file into <page>, reusing its storage:
+   * the page takes the file's page size, and its memory is not reallocated
+   * as long as it was constructed at least that large.  The buffer manager
+   * reads pages into its frames this way, so frame memory stays where it
+   * was placed.  If the read fails, <page> holds unspecified contents.
+   *
+   * @param page_number   Number of page to read.
+   * @param page          Page to read into.
+   * @throws  InvalidPageException  If the page doesn't exist in the file or is
+   *                                not currently used.
+   * @throws  CorruptPageException  If the page fails checksum verification.
+   */
+  void readPage(const PageId page_number, Page& page) const;
+
   /**
    * Writes a page into the file, replacing any existing contents.  The page
    * must have been already allocated in this file by a call to allocatePage().
    *
    * @see allocatePage()
    * @param new_page  Page to write.
+   * @throws  InvalidPageSizeException  If the page is not of the file's page
+   *                                    size.
    */
   void writePage(const Page& new_page);
 
@@ -178,6 +240,13 @@ class File {
    */
   const std::string& filename() const { return filename_; }
 
+  /**
+   * Returns the size in bytes of the pages of this file.
+   *
+   * @return Page size.
+   */
+  std::size_t page_size() const { return page_size_; }
+
   /**
    * Returns an iterator at the first page in the file.
    *
@@ -201,8 +270,9 @@ class File {
    * @param page_number   Number of page.
    * @return  Position of page in file.
    */
-  static std::streampos pagePosition(const PageId page_number) {
-    return sizeof(FileHeader) + ((page_number - 1) * Page::SIZE);
+  std::streampos pagePosition(const PageId page_number) const {
+    return sizeof(FileHeader) +
+        (static_cast<std::streamoff>(page_number - 1) * page_size_);
   }
 
   /**
@@ -212,14 +282,18 @@ class File {
    *
    * @see File::create()
    * @see File::open()
-   * @param name        Name of file.
-   * @param create_new  Whether to create a new file.
-   * @throws  FileExistsException     If the underlying file exists and
-   *                                  create_new is true.
-   * @throws  FileNotFoundException   If the underlying file doesn't exist and
-   *                                  create_new is false.
+   * @param name            Name of file.
+   * @param create_new      Whether to create a new file.
+   * @param compress_pages  Whether a new file stores page images compressed.
+   * @param page_size       Size of the pages of a new file.
+   * @throws  FileExistsException       If the underlying file exists and
+   *                                    create_new is true.
+   * @throws  FileNotFoundException     If the underlying file doesn't exist
+   *                                    and create_new is false.
+   * @throws  InvalidPageSizeException  If the page size is not supported.
    */
-  File(const std::string& name, const bool create_new);
+  File(const std::string& name, const bool create_new,
+       const bool compress_pages, const std::size_t page_size);
 
   /**
    * Opens the underlying file named in filename_.
@@ -256,6 +330,19 @@ class File {
    */
   Page readPage(const PageId page_number, const bool allow_free) const;
 
+  /**
+   * Reads a page from the file into <page> like readPage(page_number,
+   * allow_free), reusing the page's storage.
+   *
+   * @param page_number   Number of page to read.
+   * @param allow_free    Whether to allow reading a free (unused) page.
+   * @param page          Page to read into.
+   * @throws  InvalidPageException  If the page is free (unused) and
+   *                                allow_free is false.
+   */
+  void readPage(const PageId page_number, const bool allow_free,
+                Page& page) const;
+
   /**
    * Writes a page into the file at the given page number.  This does not
    * update ensure that the number in the header equals the position on disk.
@@ -278,6 +365,50 @@ class File {
   void writePage(const PageId page_number, const PageHeader& header,
                  const Page& new_page);
 
+  /**
+   * Writes the data area of a page in compressed form at the current write
+   * position.  The free space between the slot array and the records is
+   * elided before compression.
+   *
+   * @param header    Header of page to write.
+   * @param new_page  Page to write.
+   * @return  Number of bytes written.
+   */
+  std::size_t writeCompressedData(const PageHeader& header,
+                                  const Page& new_page);
+
+  /**
+   * Releases the disk blocks of a page's place in the file past its first
+   * <used> bytes, by punching a hole where the filesystem supports it.  The
+   * hole reads back as zeros and the file keeps its size.
+   *
+   * @param page_number   Number of page just written.
+   * @param used          Number of bytes of the page's place in use.
+   */
+  void releaseSlack(const PageId page_number, const std::size_t used);
+
+  /**
+   * Reads the data area of a page written by writeCompressedData from the
+   * current read position into the given page, whose header must already be
+   * filled in.
+   *
+   * @param page_number   Number of page being read.
+   * @param page          Page to fill in.
+   * @throws  InvalidPageException  If the stored image is corrupt.
+   */
+  void readCompressedData(const PageId page_number, Page& page) const;
+
+  /**
+   * Returns the checksum of a page as it will be stored on disk: the CRC32C
+   * of the header (with its checksum field zeroed) and of the data area
+   * outside the free space between the slot array and the records.
+   *
+   * @param header  Header of the page.
+   * @param page    Page whose data area to checksum.
+   * @return  Checksum of the page.
+   */
+  static std::uint32_t pageChecksum(const PageHeader& header, const Page& page);
+
   /**
    * Reads the header for this file from disk.
    *
@@ -304,12 +435,18 @@ class File {
   typedef std::map<std::string,
                    std::shared_ptr<std::fstream> > StreamMap;
   typedef std::map<std::string, int> CountMap;
+  typedef std::map<std::string, int> DescriptorMap;
 
   /**
    * Streams for opened files.
    */
   static StreamMap open_streams_;
 
+  /**
+   * Descriptors for opened files, used to punch holes; -1 where unsupported.
+   */
+  static DescriptorMap open_descriptors_;
+
   /**
    * Counts for opened files.
    */
@@ -325,6 +462,16 @@ class File {
    */
   std::shared_ptr<std::fstream> stream_;
 
+  /**
+   * Whether page images are stored compressed; cached from the file header.
+   */
+  bool compressed_;
+
+  /**
+   * Size of the file's pages in bytes; cached from the file header.
+   */
+  std::size_t page_size_;
+
   friend class FileIterator;
   friend class FileTest;
 };
@@ -0,0 +1,78 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "exceptions/invalid_record_exception.h"
+#include "page.h"
+#include "pax_page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief View which lays out a Page as an array of fixed-length records.
+ *
+ * There is no slot directory: a presence bitmap tracks which slots are in
+ * use and the record in slot s lives at (s - 1) * record_width() within the
+ * record array.  Insert, lookup and delete are O(1): deleted slots are
+ * reused from a free list threaded through their record bytes (records
+ * shorter than a SlotId fall back to a bitmap search).  A page holds records
+ * with only one bit of overhead each instead of a PageSlot.  Since the records are contiguous,
+ * a scan is a linear pass over the record array guided by the bitmap.
+ *
+ * This is the single-column case of the PAX layout, and shares its on-page
+ * format and API; see PaxPage.
+ *
+ * @warning This class is not threadsafe.
+ */
+class FixedPage : public PaxPage {
+ public:
+  /**
+   * Constructs a fixed-length view over the given page.  The page must
+   * outlive the view (typically it is pinned in the buffer pool).
+   *
+   * @param page          Page to view.
+   * @param record_width  Length of every record in bytes.
+   */
+  FixedPage(Page* page, const std::size_t record_width)
+      : PaxPage(page, std::vector<std::size_t>(1, record_width)) {
+  }
+
+  /**
+   * Returns the length of every record in bytes.
+   */
+  std::size_t record_width() const { return column_width(0); }
+
+  /**
+   * Returns a view of the record with the given ID without copying it.
+   *
+   * @param record_id  ID of the record to view.
+   * @return  View of the record.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  RecordView getRecordView(const RecordId& record_id) const {
+    if (record_id.page_number != page_number() ||
+        !isUsed(record_id.slot_number)) {
+      throw InvalidRecordException(record_id, page_number());
+    }
+    const std::size_t offset = (record_id.slot_number - 1) * record_width();
+    RecordView view = {records() + offset, record_width()};
+    return view;
+  }
+
+  /**
+   * Returns the record array.  The record in slot s is at
+   * records() + (s - 1) * record_width(); slots that are not in use hold
+   * unspecified bytes.
+   */
+  const char* records() const { return column_data(0); }
+};
+
+}
@@ -0,0 +1,232 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "heap_file.h"
+
+#include <cstring>
+
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_record_length_exception.h"
+#include "file_iterator.h"
+#include "overflow_page.h"
+
+namespace badgerdb {
+
+HeapFile::HeapFile(BufMgr* buf_mgr, File* file)
+    : buf_mgr_(buf_mgr),
+      file_(file) {
+  for (FileIterator iter = file_->begin(); iter != file_->end(); ++iter) {
+    Page* page;
+    buf_mgr_->readPage(file_, iter.page_number(), page);
+    trackFreeSpace(*page);
+    buf_mgr_->unPinPage(file_, iter.page_number(), false);
+  }
+}
+
+RecordId HeapFile::insert(const std::string& record_data) {
+  // Ask for room for a new slot as well, so any page we pick is sure to
+  // accept the record.
+  const std::size_t needed = record_data.length() + sizeof(PageSlot);
+  const std::size_t data_size = file_->page_size() - sizeof(PageHeader);
+  if (needed > data_size) {
+    throw InsufficientSpaceException(
+        Page::INVALID_NUMBER, record_data.length(),
+        data_size - sizeof(PageSlot));
+  }
+
+  // The guard drops the pin if the insert or the bookkeeping throws.
+  PageGuard page;
+  std::set<std::pair<std::size_t, PageId> >::const_iterator candidate =
+      pages_by_free_space_.lower_bound(
+          std::make_pair(needed, Page::INVALID_NUMBER));
+  if (candidate != pages_by_free_space_.end()) {
+    page = buf_mgr_->readPage(file_, candidate->second);
+  } else {
+    PageId page_number;
+    page = buf_mgr_->allocPage(file_, page_number);
+  }
+
+  const RecordId record_id = page->insertRecord(record_data);
+  page.markDirty();
+  trackFreeSpace(*page);
+  return record_id;
+}
+
+std::string HeapFile::get(const RecordId& record_id) {
+  Page* page;
+  buf_mgr_->readPage(file_, record_id.page_number, page);
+  std::string record_data;
+  try {
+    record_data = page->getRecord(record_id);
+  } catch (...) {
+    buf_mgr_->unPinPage(file_, record_id.page_number, false);
+    throw;
+  }
+  buf_mgr_->unPinPage(file_, record_id.page_number, false);
+  return record_data;
+}
+
+std::size_t HeapFile::get(const RecordId& record_id, char* out,
+                          const std::size_t capacity) {
+  Page* page;
+  buf_mgr_->readPage(file_, record_id.page_number, page);
+  std::size_t length;
+  try {
+    length = page->getRecord(record_id, out, capacity);
+  } catch (...) {
+    buf_mgr_->unPinPage(file_, record_id.page_number, false);
+    throw;
+  }
+  buf_mgr_->unPinPage(file_, record_id.page_number, false);
+  return length;
+}
+
+void HeapFile::update(const RecordId& record_id,
+                      const std::string& record_data) {
+  Page* page;
+  buf_mgr_->readPage(file_, record_id.page_number, page);
+  try {
+    page->updateRecord(record_id, record_data);
+  } catch (...) {
+    buf_mgr_->unPinPage(file_, record_id.page_number, false);
+    throw;
+  }
+  trackFreeSpace(*page);
+  buf_mgr_->unPinPage(file_, record_id.page_number, true);
+}
+
+void HeapFile::erase(const RecordId& record_id) {
+  Page* page;
+  buf_mgr_->readPage(file_, record_id.page_number, page);
+  try {
+    page->deleteRecord(record_id);
+  } catch (...) {
+    buf_mgr_->unPinPage(file_, record_id.page_number, false);
+    throw;
+  }
+  trackFreeSpace(*page);
+  buf_mgr_->unPinPage(file_, record_id.page_number, true);
+}
+
+RecordId HeapFile::insertLarge(const std::string& value) {
+  // Write the chunks back to front so that each page knows its successor
+  // when it is written.
+  PageId next_chunk = Page::INVALID_NUMBER;
+  const std::size_t capacity = OverflowPage::capacity(file_->page_size());
+  std::size_t chunk_end = value.length();
+  while (chunk_end > 0) {
+    const std::size_t chunk_begin = (chunk_end - 1) / capacity * capacity;
+    PageId page_number;
+    PageGuard page = buf_mgr_->allocPage(file_, page_number);
+    OverflowPage(page.get()).initialize(next_chunk, value.data() + chunk_begin,
+                                        chunk_end - chunk_begin);
+    page.markDirty();
+    trackFreeSpace(*page);
+    next_chunk = page_number;
+    chunk_end = chunk_begin;
+  }
+
+  LargeRecordStub stub;
+  std::memset(&stub, 0, sizeof(stub));
+  stub.length = value.length();
+  stub.first_chunk = next_chunk;
+  return insert(std::string(reinterpret_cast<const char*>(&stub),
+                            sizeof(stub)));
+}
+
+std::string HeapFile::getLarge(const RecordId& record_id) {
+  LargeRecordReader reader(this, record_id);
+  std::string value;
+  value.reserve(reader.length());
+  RecordView chunk;
+  while (reader.next(chunk)) {
+    value.append(chunk.data, chunk.length);
+  }
+  return value;
+}
+
+void HeapFile::eraseLarge(const RecordId& record_id) {
+  const LargeRecordStub stub = getLargeStub(record_id);
+  PageId chunk = stub.first_chunk;
+  while (chunk != Page::INVALID_NUMBER) {
+    Page* page;
+    buf_mgr_->readPage(file_, chunk, page);
+    const PageId next_chunk = OverflowPage(page).next_chunk();
+    buf_mgr_->unPinPage(file_, chunk, false);
+    buf_mgr_->disposePage(file_, chunk);
+    pages_by_free_space_.erase(std::make_pair(free_space_[chunk], chunk));
+    free_space_.erase(chunk);
+    chunk = next_chunk;
+  }
+  erase(record_id);
+}
+
+HeapFile::LargeRecordStub HeapFile::getLargeStub(const RecordId& record_id) {
+  const std::string record_data = get(record_id);
+  if (record_data.length() != sizeof(LargeRecordStub)) {
+    throw InvalidRecordLengthException(
+        record_id.page_number, sizeof(LargeRecordStub), record_data.length());
+  }
+  LargeRecordStub stub;
+  std::memcpy(&stub, record_data.data(), sizeof(stub));
+  return stub;
+}
+
+void HeapFile::trackFreeSpace(const Page& page) {
+  // Pages of other formats, such as dictionary pages, take no heap records.
+  const std::size_t free_space =
+      page.format() == PAGE_FORMAT_SLOTTED ? page.getFreeSpace() : 0;
+  std::map<PageId, std::size_t>::iterator entry =
+      free_space_.find(page.page_number());
+  if (entry != free_space_.end()) {
+    pages_by_free_space_.erase(std::make_pair(entry->second, entry->first));
+    entry->second = free_space;
+  } else {
+    entry = free_space_.insert(
+        std::make_pair(page.page_number(), free_space)).first;
+  }
+  pages_by_free_space_.insert(std::make_pair(entry->second, entry->first));
+}
+
+LargeRecordReader::LargeRecordReader(HeapFile* heap,
+                                     const RecordId& record_id)
+    : buf_mgr_(heap->buf_mgr_),
+      file_(heap->file_),
+      length_(0),
+      next_chunk_(Page::INVALID_NUMBER),
+      pinned_chunk_(Page::INVALID_NUMBER) {
+  const HeapFile::LargeRecordStub stub = heap->getLargeStub(record_id);
+  length_ = stub.length;
+  next_chunk_ = stub.first_chunk;
+}
+
+LargeRecordReader::~LargeRecordReader() {
+  release();
+}
+
+bool LargeRecordReader::next(RecordView& chunk) {
+  release();
+  if (next_chunk_ == Page::INVALID_NUMBER) {
+    return false;
+  }
+  Page* page;
+  buf_mgr_->readPage(file_, next_chunk_, page);
+  pinned_chunk_ = next_chunk_;
+  const OverflowPage overflow_page(page);
+  chunk = overflow_page.chunk();
+  next_chunk_ = overflow_page.next_chunk();
+  return true;
+}
+
+void LargeRecordReader::release() {
+  if (pinned_chunk_ != Page::INVALID_NUMBER) {
+    buf_mgr_->unPinPage(file_, pinned_chunk_, false);
+    pinned_chunk_ = Page::INVALID_NUMBER;
+  }
+}
+
+}
@@ -0,0 +1,295 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "scan.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Unordered file of records accessed by RecordId.
+ *
+ * A heap file stores variable-length records in the slotted pages of a File.
+ * Every page access goes through the buffer manager; pages are pinned only
+ * for the duration of a call.  An in-memory free space map, built when the
+ * heap file is opened and kept up to date by every operation, lets inserts
+ * pick a page with room without scanning the file.
+ *
+ * @warning This class is not threadsafe.
+ */
+class HeapFile {
+ public:
+  /**
+   * Opens a heap file over the given file.  Reads every page once through
+   * the buffer manager to build the free space map.
+   *
+   * @param buf_mgr Buffer manager to access pages through.
+   * @param file    File holding the records.
+   */
+  HeapFile(BufMgr* buf_mgr, File* file);
+
+  /**
+   * Inserts a record, reusing free space in an existing page if any page has
+   * room, and allocating a new page otherwise.
+   *
+   * @param record_data  Bytes that compose the record.
+   * @return  ID of the newly inserted record.
+   * @throws  InsufficientSpaceException  If the record would not fit even in
+   *                                      an empty page; use insertLarge for
+   *                                      such records.
+   */
+  RecordId insert(const std::string& record_data);
+
+  /**
+   * Inserts a value of any size.  The value is split into chunks stored on a
+   * chain of overflow pages, and a small stub pointing at the chain is
+   * inserted as a regular record.  Large values must be read and deleted
+   * with getLarge / LargeRecordReader and eraseLarge.
+   *
+   * @see OverflowPage
+   * @param value  Bytes that compose the value.
+   * @return  ID of the stub record.
+   */
+  RecordId insertLarge(const std::string& value);
+
+  /**
+   * Returns a copy of the large value with the given stub ID.  To avoid
+   * materializing the whole value, read it with a LargeRecordReader.
+   *
+   * @param record_id  ID of the stub record returned by insertLarge.
+   * @return  The value.
+   * @throws  InvalidRecordException        If the ID does not refer to a
+   *                                        record.
+   * @throws  InvalidRecordLengthException  If the record is not a stub.
+   */
+  std::string getLarge(const RecordId& record_id);
+
+  /**
+   * Deletes the large value with the given stub ID, disposing of its
+   * overflow pages.
+   *
+   * @param record_id  ID of the stub record returned by insertLarge.
+   * @throws  InvalidRecordException        If the ID does not refer to a
+   *                                        record.
+   * @throws  InvalidRecordLengthException  If the record is not a stub.
+   */
+  void eraseLarge(const RecordId& record_id);
+
+  /**
+   * Returns a copy of the record with the given ID.
+   *
+   * @param record_id  ID of the record to return.
+   * @return  The record.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  std::string get(const RecordId& record_id);
+
+  /**
+   * Copies the record with the given ID into a caller-owned buffer without
+   * any heap allocation.  If the record is longer than the buffer nothing is
+   * copied.
+   *
+   * @see Page::getRecord
+   * @param record_id  ID of the record to copy.
+   * @param out        Buffer to copy the record into.
+   * @param capacity   Length of the buffer in bytes.
+   * @return  Length of the record.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  std::size_t get(const RecordId& record_id, char* out,
+                  const std::size_t capacity);
+
+  /**
+   * Replaces the record with the given ID.  The record ID does not change,
+   * so the new version must fit on the record's page.
+   *
+   * @param record_id   ID of record to update.
+   * @param record_data Updated bytes that compose the record.
+   * @throws  InvalidRecordException      If the ID does not refer to a record.
+   * @throws  InsufficientSpaceException  If the new version does not fit on
+   *                                      the record's page.
+   */
+  void update(const RecordId& record_id, const std::string& record_data);
+
+  /**
+   * Deletes the record with the given ID.
+   *
+   * @param record_id   ID of the record to delete.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  void erase(const RecordId& record_id);
+
+  /**
+   * Appends the IDs of all records satisfying <predicate> to <matches>.  The
+   * predicate is evaluated against the record bytes inside the buffer pool.
+   *
+   * @see scanFile
+   * @param predicate Callable taking a const RecordView& and returning bool.
+   * @param matches   Vector to append matching record IDs to.
+   */
+  template <typename Predicate>
+  void scan(Predicate predicate, std::vector<RecordId>& matches) {
+    scanFile(buf_mgr_, file_, predicate, matches);
+  }
+
+  /**
+   * Returns the number of pages in the heap file.
+   */
+  std::size_t num_pages() const { return free_space_.size(); }
+
+ private:
+  /**
+   * @brief Record stored in place of a large value.
+   */
+  struct LargeRecordStub {
+    /**
+     * Length of the value in bytes.
+     */
+    std::uint64_t length;
+
+    /**
+     * Page number of the first overflow page, or Page::INVALID_NUMBER for an
+     * empty value.
+     */
+    PageId first_chunk;
+  };
+
+  /**
+   * Reads the stub record with the given ID.
+   *
+   * @param record_id  ID of the stub record.
+   * @return  The stub.
+   * @throws  InvalidRecordLengthException  If the record is not a stub.
+   */
+  LargeRecordStub getLargeStub(const RecordId& record_id);
+
+  /**
+   * Records the free space of the given page in the free space map.
+   *
+   * @param page  Page whose free space changed.
+   */
+  void trackFreeSpace(const Page& page);
+
+  /**
+   * Buffer manager to access pages through.
+   */
+  BufMgr* buf_mgr_;
+
+  /**
+   * File holding the records.
+   */
+  File* file_;
+
+  /**
+   * Free space in bytes of every page, keyed by page number.
+   */
+  std::map<PageId, std::size_t> free_space_;
+
+  /**
+   * The same information ordered by free space, so that the page with the
+   * least sufficient space can be found with one lookup.
+   */
+  std::set<std::pair<std::size_t, PageId> > pages_by_free_space_;
+
+  friend class LargeRecordReader;
+};
+
+/**
+ * @brief Streaming reader for a large value stored by HeapFile::insertLarge.
+ *
+ * The reader walks the overflow chain one chunk at a time, keeping only the
+ * page of the current chunk pinned, so values far larger than the buffer
+ * pool can be read.
+ *
+ * @code
+ *   LargeRecordReader reader(&heap, stub_id);
+ *   RecordView chunk;
+ *   while (reader.next(chunk)) {
+ *     out.write(chunk.data, chunk.length);
+ *   }
+ * @endcode
+ */
+class LargeRecordReader {
+ public:
+  /**
+   * Constructs a reader positioned before the first chunk of a large value.
+   *
+   * @param heap       Heap file holding the value.
+   * @param record_id  ID of the stub record returned by insertLarge.
+   * @throws  InvalidRecordException        If the ID does not refer to a
+   *                                        record.
+   * @throws  InvalidRecordLengthException  If the record is not a stub.
+   */
+  LargeRecordReader(HeapFile* heap, const RecordId& record_id);
+
+  /**
+   * Unpins the page of the current chunk, if any.
+   */
+  ~LargeRecordReader();
+
+  /**
+   * Returns the length of the whole value in bytes.
+   */
+  std::uint64_t length() const { return length_; }
+
+  /**
+   * Advances to the next chunk of the value.  The view stays valid until the
+   * next call or until the reader is destroyed.
+   *
+   * @param chunk  Set to a view of the next chunk.
+   * @return  False if there are no more chunks.
+   */
+  bool next(RecordView& chunk);
+
+ private:
+  LargeRecordReader(const LargeRecordReader&) = delete;
+  LargeRecordReader& operator=(const LargeRecordReader&) = delete;
+
+  /**
+   * Unpins the page of the current chunk, if any.
+   */
+  void release();
+
+  /**
+   * Buffer manager to access pages through.
+   */
+  BufMgr* buf_mgr_;
+
+  /**
+   * File holding the value.
+   */
+  File* file_;
+
+  /**
+   * Length of the whole value in bytes.
+   */
+  std::uint64_t length_;
+
+  /**
+   * Page number of the chunk that next() will return.
+   */
+  PageId next_chunk_;
+
+  /**
+   * Page number of the currently pinned chunk, or Page::INVALID_NUMBER.
+   */
+  PageId pinned_chunk_;
+};
+
+}
@@ -0,0 +1,217 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "lz_codec.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Shortest back-reference worth encoding.
+ */
+const std::size_t MIN_MATCH = 4;
+
+/**
+ * Longest distance a back-reference can reach.
+ */
+const std::size_t MAX_OFFSET = 65535;
+
+/**
+ * Number of bits in a match-finder hash.
+ */
+const int HASH_BITS = 12;
+
+/**
+ * Length nibble value meaning "more length bytes follow".
+ */
+const std::size_t RUN_MASK = 15;
+
+std::uint32_t read32(const unsigned char* p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::uint32_t hashSequence(const std::uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * Appends the extra bytes of a length that did not fit in its nibble.
+ * Returns false if the destination is full.
+ */
+bool writeLength(std::size_t length, unsigned char*& op,
+                 const unsigned char* op_end) {
+  for (; length >= 255; length -= 255) {
+    if (op == op_end) {
+      return false;
+    }
+    *op++ = 255;
+  }
+  if (op == op_end) {
+    return false;
+  }
+  *op++ = static_cast<unsigned char>(length);
+  return true;
+}
+
+/**
+ * Reads the extra bytes of a length whose nibble was RUN_MASK.  Returns
+ * false if the input ends first.
+ */
+bool readLength(std::size_t& length, const unsigned char*& ip,
+                const unsigned char* ip_end) {
+  unsigned char byte;
+  do {
+    if (ip == ip_end) {
+      return false;
+    }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * Appends one sequence: literals, then (unless this is the last sequence) a
+ * back-reference.  Returns false if the destination is full.
+ */
+bool writeSequence(const unsigned char* literals,
+                   const std::size_t num_literals, const std::size_t offset, const std::size_t match_length,
+                   unsigned char*& op, const unsigned char* op_end) {
+  if (op == op_end) {
+    return false;
+  }
+  unsigned char* token = op++;
+  *token = (num_literals < RUN_MASK ? num_literals : RUN_MASK) << 4;
+  if (num_literals >= RUN_MASK &&
+      !writeLength(num_literals - RUN_MASK, op, op_end)) {
+    return false;
+  }
+  if (static_cast<std::size_t>(op_end - op) < num_literals) {
+    return false;
+  }
+  std::memcpy(op, literals, num_literals);
+  op += num_literals;
+  if (match_length == 0) {
+    return true;
+  }
+
+  if (op_end - op < 2) {
+    return false;
+  }
+  *op++ = static_cast<unsigned char>(offset & 0xff);
+  *op++ = static_cast<unsigned char>(offset >> 8);
+  const std::size_t length_code = match_length - MIN_MATCH;
+  *token |= length_code < RUN_MASK ? length_code : RUN_MASK;
+  if (length_code >= RUN_MASK &&
+      !writeLength(length_code - RUN_MASK, op, op_end)) {
+    return false;
+  }
+  return true;
+}
+
+}
+
+std::size_t lzCompress(const char* src, const std::size_t src_length,
+                       char* dst, const std::size_t dst_capacity) {
+  const unsigned char* in = reinterpret_cast<const unsigned char*>(src);
+  unsigned char* op = reinterpret_cast<unsigned char*>(dst);
+  const unsigned char* op_end = op + dst_capacity;
+
+  // Positions (plus one, so zero means empty) of recent 4-byte sequences.
+  std::uint32_t table[1 << HASH_BITS];
+  std::memset(table, 0, sizeof(table));
+
+  std::size_t anchor = 0;
+  std::size_t pos = 0;
+  while (pos + MIN_MATCH <= src_length) {
+    const std::uint32_t sequence = read32(in + pos);
+    const std::uint32_t hash = hashSequence(sequence);
+    const std::size_t candidate = table[hash];
+    table[hash] = static_cast<std::uint32_t>(pos + 1);
+    if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET ||
+        read32(in + candidate - 1) != sequence) {
+      ++pos;
+      continue;
+    }
+
+    const std::size_t match = candidate - 1;
+    std::size_t match_length = MIN_MATCH;
+    while (pos + match_length < src_length &&
+           in[match + match_length] == in[pos + match_length]) {
+      ++match_length;
+    }
+    if (!writeSequence(in + anchor, pos - anchor, pos - match, match_length,
+                       op, op_end)) {
+      return 0;
+    }
+    pos += match_length;
+    anchor = pos;
+  }
+
+  if (!writeSequence(in + anchor, src_length - anchor, 0, 0, op, op_end)) {
+    return 0;
+  }
+  return op - reinterpret_cast<unsigned char*>(dst);
+}
+
+bool lzDecompress(const char* src, const std::size_t src_length,
+                  char* dst, const std::size_t dst_length) {
+  const unsigned char* ip = reinterpret_cast<const unsigned char*>(src);
+  const unsigned char* ip_end = ip + src_length;
+  unsigned char* out = reinterpret_cast<unsigned char*>(dst);
+  unsigned char* op = out;
+  const unsigned char* op_end = out + dst_length;
+
+  while (ip < ip_end) {
+    const unsigned char token = *ip++;
+    std::size_t num_literals = token >> 4;
+    if (num_literals == RUN_MASK && !readLength(num_literals, ip, ip_end)) {
+      return false;
+    }
+    if (static_cast<std::size_t>(ip_end - ip) < num_literals ||
+        static_cast<std::size_t>(op_end - op) < num_literals) {
+      return false;
+    }
+    std::memcpy(op, ip, num_literals);
+    ip += num_literals;
+    op += num_literals;
+    if (ip == ip_end) {
+      // The last sequence has no back-reference.
+      break;
+    }
+
+    if (ip_end - ip < 2) {
+      return false;
+    }
+    const std::size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    std::size_t match_length = token & RUN_MASK;
+    if (match_length == RUN_MASK && !readLength(match_length, ip, ip_end)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<std::size_t>(op - out) ||
+        static_cast<std::size_t>(op_end - op) < match_length) {
+      return false;
+    }
+    // Copy byte by byte since the match may overlap the bytes it produces.
+    const unsigned char* match = op - offset;
+    for (std::size_t i = 0; i < match_length; ++i) {
+      op[i] = match[i];
+    }
+    op += match_length;
+  }
+  return op == op_end;
+}
+
+}
@@ -0,0 +1,43 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace badgerdb {
+
+/**
+ * Compresses a buffer with a byte-oriented LZ77 codec (LZ4-style sequences
+ * of literals followed by a back-reference of at most 64 KB).  The codec
+ * favors speed over ratio and needs no dictionary or external library.
+ *
+ * @param src           Bytes to compress.
+ * @param src_length    Number of bytes to compress.
+ * @param dst           Buffer for the compressed bytes.
+ * @param dst_capacity  Size of the destination buffer.
+ * @return  Number of compressed bytes, or 0 if they would not fit in
+ *          dst_capacity bytes.
+ */
+std::size_t lzCompress(const char* src, const std::size_t src_length,
+                       char* dst, const std::size_t dst_capacity);
+
+/**
+ * Decompresses a buffer produced by lzCompress.  Corrupt input is detected
+ * rather than read or written out of bounds.
+ *
+ * @param src           Compressed bytes.
+ * @param src_length    Number of compressed bytes.
+ * @param dst           Buffer for the decompressed bytes.
+ * @param dst_length    Exact number of bytes the input decompresses to.
+ * @return  True if the input was well formed and decompressed to exactly
+ *          dst_length bytes.
+ */
+bool lzDecompress(const char* src, const std::size_t src_length,
+                  char* dst, const std::size_t dst_length);
+
+}
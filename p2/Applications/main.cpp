@@ -7,20 +7,44 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <atomic>
+#include <cstddef>
 #include <iostream>
 #include <stdlib.h>
 //#include <stdio.h>
 #include <cstring>
+#include <fstream>
+#include <map>
 #include <memory>
+#include <thread>
+#include <vector>
+#include "benchmarks.h"
+#include "packed_tuple.h"
 #include "page.h"
 #include "buffer.h"
+#include "dict_page.h"
+#include "fixed_page.h"
+#include "event_loop.h"
 #include "file_iterator.h"
+#include "heap_file.h"
 #include "page_iterator.h"
+#include "pax_page.h"
+#include "scan.h"
+#include "schema.h"
+#include "sorted_page.h"
+#include "task_scheduler.h"
+#include "vacuum.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/invalid_page_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/corrupt_page_exception.h"
+#include "exceptions/invalid_page_size_exception.h"
+#include "exceptions/page_format_exception.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_record_exception.h"
+#include "exceptions/invalid_record_length_exception.h"
 
 #define PRINT_ERROR(str) \
 { \
@@ -52,10 +76,41 @@ void test9();
 void test10();
 void test11();
 void test12();
+void test13();
+void test14();
+void test15();
+void test16();
+void test17();
+void test18();
+void test19();
+void test20();
+void test21();
+void test22();
+void test23();
+void test24();
+void test25();
+void test26();
+void test27();
+void test28();
+void test29();
+void test30();
+void test31();
+void test32();
+void test33();
+void test34();
+void test35();
+void test36();
 void testBufMgr();
 
-int main() 
+int main(int argc, char* argv[])
 {
+	//Run the benchmarks instead of the tests with: badgerdb_main bench
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+	{
+		runBenchmarks(std::cout);
+		return 0;
+	}
+
 	//Following code shows how to you File and Page classes
 
   const std::string& filename = "test.db";
@@ -174,6 +229,30 @@ void testBufMgr()
 	test10();
 	test11();
 	test12();
+	test13();
+	test14();
+	test15();
+	test16();
+	test17();
+	test18();
+	test19();
+	test20();
+	test21();
+	test22();
+	test23();
+	test24();
+	test25();
+	test26();
+	test27();
+	test28();
+	test29();
+	test30();
+	test31();
+	test32();
+	test33();
+	test34();
+	test35();
+	test36();
 
 	//Close files before deleting them
 	file1.~File();
@@ -299,6 +378,10 @@ void test4()
 	{
 	}
 
+	//unpinning a page that is not in the buffer pool does nothing
+	bufMgr->flushFile(file4ptr);
+	bufMgr->unPinPage(file4ptr, i, false);
+
 	std::cout << "Test 4 passed" << "\n";
 }
 
@@ -479,3 +562,1601 @@ void test12(){ //test disposePage
 	}
 
 }
+
+void test13()
+{
+	//iterate over the used slots of a dense page and then a sparse one
+	bufMgr->allocPage(file2ptr, pageno2, page2);
+	std::vector<RecordId> rids;
+	while (page2->hasSpaceForRecord("x"))
+	{
+		rids.push_back(page2->insertRecord("x"));
+	}
+
+	std::size_t count = 0;
+	for (PageIterator iter = page2->begin(); iter != page2->end(); ++iter)
+	{
+		count++;
+	}
+	if (count != rids.size())
+	{
+		PRINT_ERROR("ERROR :: Iterator did not visit every record on a dense page");
+	}
+
+	//keep every 100th record only
+	std::size_t kept = 0;
+	for (std::size_t j = 0; j < rids.size(); j++)
+	{
+		if (j % 100 == 0)
+			kept++;
+		else
+			page2->deleteRecord(rids[j]);
+	}
+
+	count = 0;
+	for (PageIterator iter = page2->begin(); iter != page2->end(); ++iter)
+	{
+		if (*iter != "x")
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		count++;
+	}
+	if (count != kept)
+	{
+		PRINT_ERROR("ERROR :: Iterator did not visit every record on a sparse page");
+	}
+
+	//the lowest freed slot is handed out again
+	if (page2->insertRecord("y") != rids[1])
+	{
+		PRINT_ERROR("ERROR :: Freed slot was not reused");
+	}
+	bufMgr->unPinPage(file2ptr, pageno2, true);
+
+	std::cout << "Test 13 passed" << "\n";
+}
+
+void test14()
+{
+	//store fixed-schema records column-wise and scan one column after a flush
+	std::vector<std::size_t> widths;
+	widths.push_back(4);
+	widths.push_back(8);
+
+	bufMgr->allocPage(file3ptr, pageno3, page3);
+	PaxPage pax(page3, widths);
+	pax.initialize();
+	for (i = 0; i < num; i++)
+	{
+		sprintf((char*)tmpbuf, "%04u%08u", i, i * 2);
+		pax.insertRecord(std::string(tmpbuf, 12));
+	}
+	bufMgr->unPinPage(file3ptr, pageno3, true);
+	bufMgr->flushFile(file3ptr);
+
+	bufMgr->readPage(file3ptr, pageno3, page3);
+	PaxPage pax2(page3, widths);
+	i = 0;
+	for (PaxColumnIterator iter = pax2.columnBegin(1); iter != pax2.columnEnd(1); ++iter)
+	{
+		sprintf((char*)tmpbuf, "%08u", i * 2);
+		if (strncmp(*iter, tmpbuf, 8) != 0)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		i++;
+	}
+	if (i != num)
+	{
+		PRINT_ERROR("ERROR :: Column scan did not visit every record");
+	}
+
+	//the page records its format, so it cannot be read as a slotted page
+	if (page3->format() != PAGE_FORMAT_PAX)
+	{
+		PRINT_ERROR("ERROR :: PAX page did not keep its format");
+	}
+	try
+	{
+		const RecordId paxRid = {pageno3, 1};
+		page3->getRecord(paxRid);
+		PRINT_ERROR("ERROR :: Page is a PAX page. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const PageFormatException &e)
+	{
+	}
+	bufMgr->unPinPage(file3ptr, pageno3, false);
+
+	//nor can a slotted page be read as a PAX page
+	bufMgr->readPage(file5ptr, 1, page);
+	try
+	{
+		PaxPage(page, widths).columnBegin(0);
+		PRINT_ERROR("ERROR :: Page is a slotted page. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const PageFormatException &e)
+	{
+	}
+	bufMgr->unPinPage(file5ptr, 1, false);
+
+	std::cout << "Test 14 passed" << "\n";
+}
+
+void test15()
+{
+	//filter a file inside the buffer pool without copying records out
+	std::vector<RecordId> matches;
+	scanFile(bufMgr, file5ptr,
+			FieldPredicate(0, FieldPredicate::EQ, "test.5 Page 42 "), matches);
+	if (matches.size() != 1 || matches[0].page_number != 42)
+	{
+		PRINT_ERROR("ERROR :: Scan returned the wrong records");
+	}
+	bufMgr->readPage(file5ptr, matches[0].page_number, page);
+	sprintf((char*)tmpbuf, "test.5 Page %u %7.1f", 42, 42.0f);
+	if (page->getRecord(matches[0]) != tmpbuf)
+	{
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	}
+	bufMgr->unPinPage(file5ptr, matches[0].page_number, false);
+
+	matches.clear();
+	scanFile(bufMgr, file5ptr,
+			[](const RecordView& record) { return record.length > 0; }, matches);
+	if (matches.size() != num)
+	{
+		PRINT_ERROR("ERROR :: Scan did not visit every record");
+	}
+
+	std::cout << "Test 15 passed" << "\n";
+}
+
+void test16()
+{
+	//insert, read, update and erase records of a heap file
+	HeapFile heap(bufMgr, file6ptr);
+	std::vector<RecordId> rids;
+	for (i = 0; i < 10 * num; i++)
+	{
+		sprintf((char*)tmpbuf, "test.6 Record %u", i);
+		rids.push_back(heap.insert(tmpbuf));
+	}
+	const std::size_t pages = heap.num_pages();
+
+	for (i = 0; i < 10 * num; i++)
+	{
+		sprintf((char*)tmpbuf, "test.6 Record %u", i);
+		if (heap.get(rids[i]) != tmpbuf)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+	}
+
+	heap.update(rids[0], "updated");
+	if (heap.get(rids[0]) != "updated")
+	{
+		PRINT_ERROR("ERROR :: Update was not applied");
+	}
+
+	//freed space is reused instead of growing the file
+	for (i = 0; i < num; i++)
+		heap.erase(rids[i]);
+	for (i = 0; i < num; i++)
+	{
+		sprintf((char*)tmpbuf, "test.6 Record %u", i);
+		rids[i] = heap.insert(tmpbuf);
+	}
+	if (heap.num_pages() != pages)
+	{
+		PRINT_ERROR("ERROR :: Heap file did not reuse free space");
+	}
+
+	//records 42 and 420-429 share the prefix
+	std::vector<RecordId> matches;
+	heap.scan(FieldPredicate(0, FieldPredicate::EQ, "test.6 Record 42"), matches);
+	if (matches.size() != 11)
+	{
+		PRINT_ERROR("ERROR :: Scan returned the wrong records");
+	}
+
+	//a reopened heap file sees the same free space
+	HeapFile reopened(bufMgr, file6ptr);
+	if (reopened.num_pages() != pages)
+	{
+		PRINT_ERROR("ERROR :: Reopened heap file has the wrong pages");
+	}
+
+	//an insert into a page that filled up behind the heap file's back leaves it unpinned
+	const std::string& filename = "test.stale";
+	{
+		File stale = File::create(filename);
+		HeapFile staleHeap(bufMgr, &stale);
+		const RecordId first = staleHeap.insert("test.stale Record");
+		{
+			PageGuard page = bufMgr->readPage(&stale, first.page_number);
+			try
+			{
+				while (true)
+					page->insertRecord("test.stale Filler");
+			}
+			catch(const InsufficientSpaceException &e)
+			{
+			}
+			page.markDirty();
+		}
+		try
+		{
+			staleHeap.insert("test.stale Record");
+			PRINT_ERROR("ERROR :: Page is full. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const InsufficientSpaceException &e)
+		{
+		}
+		try
+		{
+			bufMgr->flushFile(&stale);
+		}
+		catch(const PagePinnedException &e)
+		{
+			PRINT_ERROR("ERROR :: Failed insert left its page pinned");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Test 16 passed" << "\n";
+}
+
+void test17()
+{
+	//store a value larger than a page and stream it back chunk by chunk
+	HeapFile heap(bufMgr, file6ptr);
+	std::string value;
+	for (i = 0; value.length() < 3 * file6ptr->page_size() + 100; i++)
+	{
+		sprintf((char*)tmpbuf, "test.6 Large %u;", i);
+		value += tmpbuf;
+	}
+	const RecordId stub = heap.insertLarge(value);
+	const std::size_t pages = heap.num_pages();
+
+	std::string streamed;
+	{
+		LargeRecordReader reader(&heap, stub);
+		RecordView chunk;
+		while (reader.next(chunk))
+		{
+			streamed.append(chunk.data, chunk.length);
+		}
+	}
+	if (streamed != value || heap.getLarge(stub) != value)
+	{
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	}
+
+	//overflow pages are returned to the file and reused
+	heap.eraseLarge(stub);
+	heap.insertLarge(value);
+	if (heap.num_pages() != pages)
+	{
+		PRINT_ERROR("ERROR :: Overflow pages were not reused");
+	}
+
+	std::cout << "Test 17 passed" << "\n";
+}
+
+void test18()
+{
+	//round trip pages of a file that stores page images compressed
+	const std::string& filename = "test.7";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+
+	{
+		File file7 = File::create(filename, true /* compress_pages */);
+		for (i = 0; i < num; i++)
+		{
+			bufMgr->allocPage(&file7, pid[i], page);
+			sprintf((char*)tmpbuf, "test.7 Page %u %7.1f", pid[i], (float)pid[i]);
+			while (page->hasSpaceForRecord(tmpbuf))
+			{
+				rid[i] = page->insertRecord(tmpbuf);
+			}
+			bufMgr->unPinPage(&file7, pid[i], true);
+		}
+		bufMgr->flushFile(&file7);
+
+		File reopened = File::open(filename);
+		for (i = 0; i < num; i++)
+		{
+			bufMgr->readPage(&reopened, pid[i], page);
+			sprintf((char*)tmpbuf, "test.7 Page %u %7.1f", pid[i], (float)pid[i]);
+			if (page->getRecord(rid[i]) != tmpbuf)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			bufMgr->unPinPage(&reopened, pid[i], false);
+		}
+		bufMgr->flushFile(&reopened);
+
+		//an image that compresses to exactly its own length is stored raw
+		Page small = reopened.allocatePage();
+		const RecordId small_rid = small.insertRecord("ABCDABCDxyz");
+		reopened.writePage(small);
+		if (reopened.readPage(small.page_number()).getRecord(small_rid) != "ABCDABCDxyz")
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Test 18 passed" << "\n";
+}
+
+void test19()
+{
+	//a page damaged on disk is detected when it is read back
+	const std::string& filename = "test.7";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+
+	PageId damaged;
+	{
+		File file7 = File::create(filename);
+		Page new_page = file7.allocatePage();
+		new_page.insertRecord("test.7 checksummed record");
+		file7.writePage(new_page);
+		damaged = new_page.page_number();
+	}
+
+	{
+		//flip a byte of the record, which sits at the end of the page
+		std::fstream stream(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		stream.seekp(-5, std::ios::end);
+		stream.put('X');
+	}
+
+	{
+		File file7 = File::open(filename);
+		try
+		{
+			file7.readPage(damaged);
+			PRINT_ERROR("ERROR :: Page is damaged. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const CorruptPageException &e)
+		{
+		}
+	}
+
+	//a damaged slot count is caught by the checksum before the slots are scanned
+	File::remove(filename);
+	std::streamoff header_position;
+	{
+		File file7 = File::create(filename);
+		Page new_page = file7.allocatePage();
+		new_page.insertRecord("test.7 checksummed record");
+		file7.writePage(new_page);
+		damaged = new_page.page_number();
+		header_position = sizeof(FileHeader) + (damaged - 1) * static_cast<std::streamoff>(file7.page_size());
+	}
+	{
+		std::fstream stream(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		const SlotId num_slots = 0xffff;
+		stream.seekp(header_position + offsetof(PageHeader, num_slots));
+		stream.write(reinterpret_cast<const char*>(&num_slots), sizeof(num_slots));
+	}
+	{
+		File file7 = File::open(filename);
+		try
+		{
+			file7.readPage(damaged);
+			PRINT_ERROR("ERROR :: Page is damaged. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const CorruptPageException &e)
+		{
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Test 19 passed" << "\n";
+}
+
+void test20()
+{
+	//repeated values are stored once per page and filtered by code
+	bufMgr->allocPage(file2ptr, pageno2, page2);
+	DictPage dict(page2, 2);
+	dict.initialize();
+	std::vector<RecordId> rids;
+	for (i = 0; i < num; i++)
+	{
+		std::vector<std::string> fields;
+		sprintf((char*)tmpbuf, "test.2 City %u", i % 5);
+		fields.push_back(tmpbuf);
+		sprintf((char*)tmpbuf, "%u", i);
+		fields.push_back(tmpbuf);
+		rids.push_back(dict.insertRecord(fields));
+	}
+	if (dict.num_entries() != 5 + num)
+	{
+		PRINT_ERROR("ERROR :: Repeated values were not shared");
+	}
+	bufMgr->unPinPage(file2ptr, pageno2, true);
+	bufMgr->flushFile(file2ptr);
+
+	bufMgr->readPage(file2ptr, pageno2, page2);
+	DictPage dict2(page2, 2);
+
+	//the slotted page API sees no records on a dictionary page and refuses to add any
+	if (page2->getNextUsedSlot(Page::INVALID_SLOT) != Page::INVALID_SLOT)
+	{
+		PRINT_ERROR("ERROR :: Dictionary page was seen as a slotted page");
+	}
+	try
+	{
+		page2->insertRecord("test.2 Raw");
+		PRINT_ERROR("ERROR :: Page is a dictionary page. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const PageFormatException &e)
+	{
+	}
+
+	//records are checked against the number of fields they are viewed with
+	try
+	{
+		DictPage wrong(page2, 1);
+		PRINT_ERROR("ERROR :: Records have two fields. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const InvalidRecordLengthException &e)
+	{
+	}
+	for (i = 0; i < num; i++)
+	{
+		sprintf((char*)tmpbuf, "test.2 City %u", i % 5);
+		if (dict2.getRecord(rids[i])[0] != tmpbuf || dict2.getField(rids[i], 0).toString() != tmpbuf)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+	}
+
+	std::vector<RecordId> matches;
+	dict2.findEqual(0, "test.2 City 3", matches);
+	if (matches.size() != num / 5)
+	{
+		PRINT_ERROR("ERROR :: Equality filter returned the wrong records");
+	}
+
+	//an entry goes away with the last record using it
+	for (std::size_t j = 0; j < matches.size(); j++)
+		dict2.deleteRecord(matches[j]);
+	SlotId code;
+	if (dict2.lookupCode("test.2 City 3", code) || dict2.num_entries() != 4 + num - num / 5)
+	{
+		PRINT_ERROR("ERROR :: Unused dictionary entries were not dropped");
+	}
+	bufMgr->unPinPage(file2ptr, pageno2, true);
+
+	std::cout << "Test 20 passed" << "\n";
+}
+
+std::string sortedKey(const RecordView& record)
+{
+	return std::string(record.data, 15);
+}
+
+struct RecordCounter
+{
+	std::size_t count;
+	void operator()(const RecordView&) { count++; }
+};
+
+void test21()
+{
+	//records inserted out of order come back ordered by key
+	bufMgr->allocPage(file3ptr, pageno3, page3);
+	SortedPage sorted(page3, sortedKey);
+	sorted.initialize();
+	for (i = 0; i < num; i++)
+	{
+		sprintf((char*)tmpbuf, "test.3 Key %04u Record", (i * 37) % num);
+		sorted.insertRecord(tmpbuf);
+	}
+	bufMgr->unPinPage(file3ptr, pageno3, true);
+	bufMgr->flushFile(file3ptr);
+
+	bufMgr->readPage(file3ptr, pageno3, page3);
+	SortedPage sorted2(page3, sortedKey);
+	if (sorted2.num_records() != num || sorted2.prefix_length() < strlen("test.3 Key "))
+	{
+		PRINT_ERROR("ERROR :: Keys were not prefix-compressed");
+	}
+	for (i = 0; i < num; i++)
+	{
+		sprintf((char*)tmpbuf, "test.3 Key %04u Record", i);
+		if (sorted2.getRecord(i).toString() != tmpbuf)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+	}
+
+	std::size_t position;
+	if (!sorted2.find("test.3 Key 0042", position) || position != 42 || sorted2.find("test.3 Key 9999", position))
+	{
+		PRINT_ERROR("ERROR :: Binary search returned the wrong record");
+	}
+	RecordCounter counter = {0};
+	sorted2.forEachInRange("test.3 Key 0010", "test.3 Key 0020", counter);
+	if (counter.count != 10)
+	{
+		PRINT_ERROR("ERROR :: Range scan returned the wrong records");
+	}
+
+	//a key outside the shared prefix shortens it but keeps the order
+	sorted2.deleteRecord(0);
+	sorted2.insertRecord("test.3 Kez 0000 Record");
+	if (sorted2.getKey(num - 1) != "test.3 Kez 0000" || sorted2.getKey(0) != "test.3 Key 0001")
+	{
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	}
+	bufMgr->unPinPage(file3ptr, pageno3, true);
+
+	std::cout << "Test 21 passed" << "\n";
+}
+
+void test22()
+{
+	//churn a heap file, then pack it into fewer pages a few pages at a time
+	std::vector<RecordId> rids;
+	{
+		//fill several pages whatever the file's page size
+		HeapFile heap(bufMgr, file6ptr);
+		const std::size_t pages = heap.num_pages();
+		for (i = 0; i < 10 * num || heap.num_pages() < pages + 4; i++)
+		{
+			sprintf((char*)tmpbuf, "test.6 Vacuum %u", i);
+			rids.push_back(heap.insert(tmpbuf));
+		}
+		for (i = 0; i < rids.size(); i++)
+		{
+			if (i % 4 != 0)
+				heap.erase(rids[i]);
+		}
+	}
+	std::vector<RecordId> before;
+	scanFile(bufMgr, file6ptr, [](const RecordView&) { return true; }, before);
+
+	Vacuum vacuum(bufMgr, file6ptr, [&rids](const RecordId& from, const RecordId& to) {
+		for (std::size_t j = 0; j < rids.size(); j++)
+		{
+			if (rids[j] == from)
+				rids[j] = to;
+		}
+	});
+	while (!vacuum.step(8))
+	{
+	}
+	if (vacuum.stats().pages_after >= vacuum.stats().pages_before || vacuum.stats().records_moved == 0)
+	{
+		PRINT_ERROR("ERROR :: Vacuum did not free any pages");
+	}
+
+	std::vector<RecordId> after;
+	scanFile(bufMgr, file6ptr, [](const RecordView&) { return true; }, after);
+	if (after.size() != before.size())
+	{
+		PRINT_ERROR("ERROR :: Vacuum lost records");
+	}
+	HeapFile reopened(bufMgr, file6ptr);
+	if (reopened.num_pages() != vacuum.stats().pages_after)
+	{
+		PRINT_ERROR("ERROR :: Vacuum reported the wrong page count");
+	}
+	for (i = 0; i < rids.size(); i += 4)
+	{
+		sprintf((char*)tmpbuf, "test.6 Vacuum %u", i);
+		if (reopened.get(rids[i]) != tmpbuf)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+	}
+
+	std::cout << "Test 22 passed" << "\n";
+}
+
+void test23()
+{
+	//copy records into a reusable buffer instead of new strings
+	bufMgr->allocPage(file5ptr, pageno1, page);
+	RecordId rids[5];
+	for (i = 0; i < 5; i++)
+	{
+		sprintf((char*)tmpbuf, "test.5 Copy %u", i);
+		rids[i] = page->insertRecord(tmpbuf);
+	}
+
+	char out[64];
+	sprintf((char*)tmpbuf, "test.5 Copy %u", 3);
+	if (page->getRecord(rids[3], out, sizeof(out)) != strlen(tmpbuf) || strncmp(out, tmpbuf, strlen(tmpbuf)) != 0)
+	{
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	}
+	out[0] = '\0';
+	if (page->getRecord(rids[3], out, 4) != strlen(tmpbuf) || out[0] != '\0')
+	{
+		PRINT_ERROR("ERROR :: Record was copied into a buffer too small for it");
+	}
+
+	//only whole records are copied, up to the end of the buffer
+	std::size_t lengths[5];
+	if (page->copyRecords(rids, 5, out, 3 * 13 + 5, lengths) != 3)
+	{
+		PRINT_ERROR("ERROR :: Batch copy did not stop at the end of the buffer");
+	}
+	std::size_t offset = 0;
+	for (i = 0; i < 3; i++)
+	{
+		sprintf((char*)tmpbuf, "test.5 Copy %u", i);
+		if (lengths[i] != strlen(tmpbuf) || strncmp(out + offset, tmpbuf, lengths[i]) != 0)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		offset += lengths[i];
+	}
+	bufMgr->unPinPage(file5ptr, pageno1, true);
+
+	std::cout << "Test 23 passed" << "\n";
+}
+
+struct ScoreSum
+{
+	const Schema* schema;
+	std::size_t column;
+	std::int64_t sum;
+	void operator()(const RecordId&, const RecordView& record)
+	{
+		sum += TupleView(*schema, record.data).getInt64(column);
+	}
+};
+
+void test24()
+{
+	//filter and aggregate typed records without parsing them
+	Schema schema;
+	const std::size_t id = schema.addColumn("id", INT32);
+	const std::size_t score = schema.addColumn("score", INT64);
+	const std::size_t name = schema.addColumn("name", CHAR, 16);
+	std::size_t found;
+	if (!schema.findColumn("score", found) || found != score || schema.record_width() != 28)
+	{
+		PRINT_ERROR("ERROR :: Schema has the wrong layout");
+	}
+
+	bufMgr->allocPage(file5ptr, pageno1, page);
+	for (i = 0; i < num; i++)
+	{
+		TupleBuilder builder(schema);
+		builder.setInt32(id, (int)i - 50);
+		builder.setInt64(score, i * 1000);
+		sprintf((char*)tmpbuf, "test.5 Tuple %u", i);
+		builder.setChar(name, tmpbuf);
+		rid[i] = page->insertRecord(builder.data());
+	}
+
+	const TupleView tuple(schema, page->getRecordView(rid[42]).data);
+	if (tuple.getInt32(id) != -8 || tuple.getInt64(score) != 42000 || tuple.getChar(name).toString() != "test.5 Tuple 42")
+	{
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	}
+
+	//ids -50..-1 are negative, which a byte comparison would get wrong
+	ColumnPredicate<std::int32_t> negative(schema, id, FieldPredicate::LT, 0);
+	ScoreSum sum = {&schema, score, 0};
+	forEachMatch(*page, negative, sum);
+	if (sum.sum != 1000 * (49 * 50 / 2))
+	{
+		PRINT_ERROR("ERROR :: Aggregate over matching records is wrong");
+	}
+	bufMgr->unPinPage(file5ptr, pageno1, true);
+
+	std::cout << "Test 24 passed" << "\n";
+}
+
+void test25()
+{
+	//nullable and variable-width fields are read in place
+	Schema schema;
+	const std::size_t id = schema.addColumn("id", INT32);
+	const std::size_t note = schema.addColumn("note", VARCHAR);
+	const std::size_t score = schema.addColumn("score", INT64);
+	const std::size_t tag = schema.addColumn("tag", VARCHAR);
+
+	bufMgr->allocPage(file5ptr, pageno1, page);
+	for (i = 0; i < num; i++)
+	{
+		PackedTupleBuilder builder(schema);
+		builder.setInt32(id, i);
+		if (i % 2 == 0)
+		{
+			sprintf((char*)tmpbuf, "test.5 Note %u", i);
+			builder.setVarchar(note, tmpbuf);
+			builder.setInt64(score, i * 1000);
+		}
+		builder.setVarchar(tag, i % 3 == 0 ? "three" : "");
+		rid[i] = page->insertRecord(builder.build());
+	}
+
+	for (i = 0; i < num; i++)
+	{
+		const PackedTupleView tuple(schema, page->getRecordView(rid[i]));
+		if (tuple.getInt32(id) != (int)i || tuple.isNull(id) || tuple.isNull(tag))
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		if (tuple.getVarchar(tag).toString() != (i % 3 == 0 ? "three" : ""))
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		sprintf((char*)tmpbuf, "test.5 Note %u", i);
+		if (i % 2 == 0 && (tuple.isNull(note) || tuple.getVarchar(note).toString() != tmpbuf || tuple.getInt64(score) != i * 1000))
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		if (i % 2 == 1 && (!tuple.isNull(note) || !tuple.isNull(score) || tuple.getVarchar(note).length != 0))
+		{
+			PRINT_ERROR("ERROR :: Null field was not null");
+		}
+	}
+
+	//a null VARCHAR field takes no bytes besides its bit and table entry
+	if (page->getRecordView(rid[1]).length != 1 + 12 + 2 * sizeof(PageOffset))
+	{
+		PRINT_ERROR("ERROR :: Null fields take space");
+	}
+	bufMgr->unPinPage(file5ptr, pageno1, true);
+
+	std::cout << "Test 25 passed" << "\n";
+}
+
+void test26()
+{
+	//guards unpin their frame when they go out of scope
+	{
+		PageGuard guard = bufMgr->allocPage(file4ptr, pageno1);
+		sprintf((char*)tmpbuf, "test.4 Guard %u", pageno1);
+		rid2 = guard->insertRecord(tmpbuf);
+		guard.markDirty();
+
+		PageGuard moved(std::move(guard));
+		if (guard || !moved || moved.get() != &bufMgr->bufPool[moved.frame()])
+		{
+			PRINT_ERROR("ERROR :: Guard was not moved");
+		}
+		try
+		{
+			bufMgr->flushFile(file4ptr);
+			PRINT_ERROR("ERROR :: Page pinned by a guard was flushed");
+		}
+		catch (const PagePinnedException &e)
+		{
+		}
+	}
+	bufMgr->flushFile(file4ptr);
+
+	//the dirty page was written back before the flush evicted it
+	{
+		PageGuard guard = bufMgr->readPage(file4ptr, pageno1);
+		PageGuard other = bufMgr->readPage(file4ptr, pageno1);
+		if (guard->getRecord(rid2) != tmpbuf)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		other = PageGuard();
+		guard.release();
+		guard.release();
+	}
+	bufMgr->flushFile(file4ptr);
+
+	//a guard whose pin was dropped with unPinPage reports it on release
+	PageGuard guard = bufMgr->readPage(file4ptr, pageno1);
+	bufMgr->unPinPage(file4ptr, pageno1, false);
+	try
+	{
+		guard.release();
+		PRINT_ERROR("ERROR :: Released a pin that was already dropped");
+	}
+	catch (const PageNotPinnedException &e)
+	{
+	}
+
+	std::cout << "Test 26 passed" << "\n";
+}
+
+void test27()
+{
+	//threads inserting into the same page under exclusive latches do not corrupt it
+	const int threads = 4;
+	const int perThread = 40;
+	{
+		PageGuard guard = bufMgr->allocPage(file4ptr, pageno1);
+	}
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; t++)
+	{
+		workers.push_back(std::thread([t]() {
+			for (int j = 0; j < perThread; j++)
+			{
+				char record[32];
+				sprintf(record, "test.4 Latch %d %d", t, j);
+				PageGuard guard = bufMgr->readPage(file4ptr, pageno1, LATCH_EXCLUSIVE);
+				guard->insertRecord(record);
+				guard.markDirty();
+			}
+		}));
+		workers.push_back(std::thread([]() {
+			for (int j = 0; j < perThread; j++)
+			{
+				PageGuard guard = bufMgr->readPage(file4ptr, pageno1, LATCH_SHARED);
+				for (PageIterator iter = guard->begin(); iter != guard->end(); ++iter)
+				{
+					if (strncmp((*iter).c_str(), "test.4 Latch ", 13) != 0)
+					{
+						PRINT_ERROR("ERROR :: Read a torn record");
+					}
+				}
+			}
+		}));
+	}
+	for (std::size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+
+	bufMgr->flushFile(file4ptr);
+	PageGuard guard = bufMgr->readPage(file4ptr, pageno1, LATCH_SHARED);
+	int found = 0;
+	for (PageIterator iter = guard->begin(); iter != guard->end(); ++iter)
+		found++;
+	if (found != threads * perThread)
+	{
+		PRINT_ERROR("ERROR :: Records were lost by concurrent inserts");
+	}
+	guard.release();
+	bufMgr->flushFile(file4ptr);
+
+	std::cout << "Test 27 passed" << "\n";
+}
+
+void test28()
+{
+	//optimistic readers never use a page caught in the middle of an update
+	{
+		PageGuard guard = bufMgr->allocPage(file4ptr, pageno1);
+		rid2 = guard->insertRecord("test.4 Version 0000");
+		rid3 = guard->insertRecord("test.4 Version 0000");
+	}
+	const int updates = 2000;
+	std::thread writer([]() {
+		for (int j = 1; j <= updates; j++)
+		{
+			char record[32];
+			sprintf(record, "test.4 Version %04d", j);
+			PageGuard guard = bufMgr->readPage(file4ptr, pageno1, LATCH_EXCLUSIVE);
+			guard->updateRecord(rid2, record);
+			guard->updateRecord(rid3, record);
+			guard.markDirty();
+		}
+	});
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 3; t++)
+	{
+		readers.push_back(std::thread([]() {
+			FrameId hint = BufMgr::NO_FRAME;
+			for (int j = 0; j < updates; j++)
+			{
+				char first[20], second[20];
+				std::size_t first_length, second_length;
+				bufMgr->readPageOptimistic(file4ptr, pageno1, hint, [&](const Page& page) {
+					first_length = page.getRecordOptimistic(rid2, first, sizeof(first));
+					second_length = page.getRecordOptimistic(rid3, second, sizeof(second));
+				});
+				if (first_length != 19 || second_length != 19 || strncmp(first, second, 19) != 0)
+				{
+					PRINT_ERROR("ERROR :: Optimistic read saw a page being updated");
+				}
+			}
+		}));
+	}
+	writer.join();
+	for (std::size_t t = 0; t < readers.size(); t++)
+		readers[t].join();
+
+	//a hint to a frame that no longer holds the page falls back to a pinned read
+	FrameId hint = BufMgr::NO_FRAME;
+	char record[20];
+	std::size_t length = 0;
+	bufMgr->readPageOptimistic(file4ptr, pageno1, hint, [&](const Page& page) {
+		length = page.getRecordOptimistic(rid2, record, sizeof(record));
+	});
+	bufMgr->flushFile(file4ptr);
+	bufMgr->readPageOptimistic(file4ptr, pageno1, hint, [&](const Page& page) {
+		length = page.getRecordOptimistic(rid2, record, sizeof(record));
+	});
+	if (length != 19 || strncmp(record, "test.4 Version 2000", 19) != 0)
+	{
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	}
+
+	//the accessor rejects ids that name no record instead of throwing
+	RecordId missing = {pageno1, 100};
+	bufMgr->readPageOptimistic(file4ptr, pageno1, hint, [&](const Page& page) {
+		length = page.getRecordOptimistic(missing, record, sizeof(record));
+	});
+	if (length != Page::INVALID_LENGTH)
+	{
+		PRINT_ERROR("ERROR :: Optimistic read found a record that does not exist");
+	}
+	bufMgr->flushFile(file4ptr);
+
+	//readers racing the page's eviction and reload only ever read the frame's own memory
+	PageId pages[4];
+	RecordId records[4];
+	for (int j = 0; j < 4; j++)
+	{
+		PageGuard guard = bufMgr->allocPage(file4ptr, pages[j]);
+		records[j] = guard->insertRecord("test.4 Evicted 0000");
+		guard.markDirty();
+	}
+	bufMgr->flushFile(file4ptr);
+	{
+		BufMgr small(2);
+		std::atomic<bool> stop(false);
+		std::thread evictor([&small, &stop, &pages]() {
+			for (int j = 0; j < 300; j++)
+			{
+				PageGuard guard = small.readPage(file4ptr, pages[1 + j % 3]);
+			}
+			stop = true;
+		});
+		FrameId evictedHint = BufMgr::NO_FRAME;
+		while (!stop)
+		{
+			small.readPageOptimistic(file4ptr, pages[0], evictedHint, [&](const Page& page) {
+				length = page.getRecordOptimistic(records[0], record, sizeof(record));
+			});
+			if (length != 19 || strncmp(record, "test.4 Evicted 0000", 19) != 0)
+			{
+				PRINT_ERROR("ERROR :: Optimistic read saw another page");
+			}
+		}
+		evictor.join();
+		small.flushFile(file4ptr);
+	}
+	for (int j = 0; j < 4; j++)
+		bufMgr->disposePage(file4ptr, pages[j]);
+
+	std::cout << "Test 28 passed" << "\n";
+}
+
+void test29()
+{
+	//a sharded pool caches, flushes and counts pages like a single one
+	BufMgr sharded(num, 4);
+	for (i = 0; i < num / 2; i++)
+	{
+		PageGuard guard = sharded.allocPage(file4ptr, pid[i]);
+		sprintf((char*)tmpbuf, "test.4 Shard %u", pid[i]);
+		rid[i] = guard->insertRecord(tmpbuf);
+		guard.markDirty();
+	}
+	sharded.flushFile(file4ptr);
+	sharded.clearBufStats();
+
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; t++)
+	{
+		readers.push_back(std::thread([&sharded, t]() {
+			for (PageId j = t % 2; j < num / 2; j += 2)
+			{
+				char record[32];
+				sprintf(record, "test.4 Shard %u", pid[j]);
+				PageGuard guard = sharded.readPage(file4ptr, pid[j], LATCH_SHARED);
+				if (guard->getRecord(rid[j]) != record)
+				{
+					PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+				}
+			}
+		}));
+	}
+	for (std::size_t t = 0; t < readers.size(); t++)
+		readers[t].join();
+
+	//every page was read by two threads, but from disk at most once
+	const BufStats& stats = sharded.getBufStats();
+	if (stats.accesses != num || stats.diskreads > (int)num / 2)
+	{
+		PRINT_ERROR("ERROR :: Sharded pool statistics are wrong");
+	}
+
+	//threads waiting for a read that fails each get the error, and no frame is left behind
+	std::atomic<int> failures(0);
+	readers.clear();
+	for (int t = 0; t < 4; t++)
+	{
+		readers.push_back(std::thread([&sharded, &failures]() {
+			for (int attempt = 0; attempt < 50; attempt++)
+			{
+				try
+				{
+					sharded.readPage(file4ptr, 100000, LATCH_SHARED);
+				}
+				catch (const InvalidPageException &e)
+				{
+					failures++;
+				}
+			}
+		}));
+	}
+	for (std::size_t t = 0; t < readers.size(); t++)
+		readers[t].join();
+	if (failures != 200)
+	{
+		PRINT_ERROR("ERROR :: Failed concurrent reads were not reported");
+	}
+	sharded.flushFile(file4ptr);
+
+	std::cout << "Test 29 passed" << "\n";
+}
+
+void test30()
+{
+	//frames come from the calling thread's NUMA partition until it is full
+	BufMgr numa(8, 1, 2);
+	{
+		std::vector<PageGuard> local;
+		for (i = 0; i < 4; i++)
+		{
+			local.push_back(numa.readPage(file4ptr, pid[i]));
+			if (local.back().frame() >= 4)
+			{
+				PRINT_ERROR("ERROR :: Page was not placed in the local partition");
+			}
+		}
+		numa.clearBufStats();
+
+		PageGuard remote = numa.readPage(file4ptr, pid[4]);
+		if (remote.frame() < 4)
+		{
+			PRINT_ERROR("ERROR :: Full local partition did not fall back to the remote one");
+		}
+		PageGuard localHit = numa.readPage(file4ptr, pid[0]);
+		PageGuard remoteHit = numa.readPage(file4ptr, pid[4]);
+	}
+
+	const BufStats& stats = numa.getBufStats();
+	if (stats.localhits != 1 || stats.remotehits != 1)
+	{
+		PRINT_ERROR("ERROR :: NUMA hit statistics are wrong");
+	}
+	numa.flushFile(file4ptr);
+
+	//pages read or allocated into a frame reuse the memory placed for it; records end where the frame does
+	BufMgr single(1);
+	const char* frameEnd;
+	PageId placed;
+	{
+		PageGuard guard = single.readPage(file4ptr, pid[0]);
+		const RecordView view = guard->getRecordView(rid[0]);
+		frameEnd = view.data + view.length;
+	}
+	{
+		PageGuard guard = single.readPage(file4ptr, pid[1]);
+		const RecordView view = guard->getRecordView(rid[1]);
+		if (view.data + view.length != frameEnd)
+		{
+			PRINT_ERROR("ERROR :: Frame memory was reallocated by a read");
+		}
+	}
+	{
+		PageGuard guard = single.allocPage(file4ptr, placed);
+		const RecordView view = guard->getRecordView(guard->insertRecord("test.4 Placed"));
+		if (view.data + view.length != frameEnd)
+		{
+			PRINT_ERROR("ERROR :: Frame memory was reallocated by an allocation");
+		}
+	}
+	single.disposePage(file4ptr, placed);
+
+	std::cout << "Test 30 passed" << "\n";
+}
+
+void test31()
+{
+	//a disposed page's frame is the next one handed out
+	BufMgr freeing(num);
+	PageId disposed;
+	FrameId frame;
+	{
+		PageGuard guard = freeing.allocPage(file4ptr, disposed);
+		frame = guard.frame();
+	}
+	freeing.disposePage(file4ptr, disposed);
+	PageId reused;
+	if (freeing.allocPage(file4ptr, reused).frame() != frame)
+	{
+		PRINT_ERROR("ERROR :: Freed frame was not reused");
+	}
+	freeing.disposePage(file4ptr, reused);
+
+	//threads allocating and disposing pages at once never share a frame
+	std::vector<std::thread> workers;
+	for (int t = 0; t < 4; t++)
+	{
+		workers.push_back(std::thread([&freeing, t]() {
+			for (int j = 0; j < 50; j++)
+			{
+				char record[32];
+				sprintf(record, "test.4 Free %d %d", t, j);
+				PageId pageNo;
+				RecordId recordId;
+				{
+					PageGuard guard = freeing.allocPage(file4ptr, pageNo, LATCH_EXCLUSIVE);
+					recordId = guard->insertRecord(record);
+					guard.markDirty();
+				}
+				{
+					PageGuard guard = freeing.readPage(file4ptr, pageNo, LATCH_SHARED);
+					if (guard->getRecord(recordId) != record)
+					{
+						PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+					}
+				}
+				freeing.disposePage(file4ptr, pageNo);
+			}
+		}));
+	}
+	for (std::size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+
+	std::cout << "Test 31 passed" << "\n";
+}
+
+void test32()
+{
+	TaskScheduler scheduler(4);
+
+	//tasks spawning and waiting for tasks of their own
+	std::atomic<int> ran(0);
+	TaskGroup group;
+	for (int t = 0; t < 10; t++)
+	{
+		scheduler.spawn(group, [&scheduler, &ran]() {
+			TaskGroup children;
+			for (int c = 0; c < 10; c++)
+				scheduler.spawn(children, [&ran]() { ran++; });
+			scheduler.wait(children);
+			ran++;
+		});
+	}
+	scheduler.wait(group);
+	if (ran != 110)
+	{
+		PRINT_ERROR("ERROR :: Not every task ran");
+	}
+
+	//a task's exception reaches the waiter
+	bool caught = false;
+	scheduler.spawn(group, []() { throw InvalidPageException(0, "test.4"); });
+	try
+	{
+		scheduler.wait(group);
+	}
+	catch (const InvalidPageException &e)
+	{
+		caught = true;
+	}
+	if (!caught)
+	{
+		PRINT_ERROR("ERROR :: Exception thrown by a task was lost");
+	}
+
+	//parallel scan of pages written by test 29, after prefetching them
+	BufMgr pool(num);
+	std::vector<PageId> pages(pid, pid + num / 2);
+	std::map<PageId, RecordId> records;
+	for (i = 0; i < num / 2; i++)
+		records[pid[i]] = rid[i];
+	TaskGroup prefetch;
+	prefetchPages(scheduler, prefetch, &pool, file4ptr, pages);
+	scheduler.wait(prefetch);
+
+	std::atomic<int> scanned(0);
+	scanPages(scheduler, &pool, file4ptr, pages, [&records, &scanned](PageId pageNo, const Page& page) {
+		char record[32];
+		sprintf(record, "test.4 Shard %u", pageNo);
+		if (page.getRecord(records.find(pageNo)->second) != record)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		scanned++;
+	});
+	if (scanned != (int)num / 2 || pool.getBufStats().diskreads != (int)num / 2)
+	{
+		PRINT_ERROR("ERROR :: Scan did not read every page once");
+	}
+	flushFiles(scheduler, &pool, std::vector<File*>(1, file4ptr));
+
+	std::cout << "Test 32 passed" << "\n";
+}
+
+void test33()
+{
+	//one thread keeps every lookup of test 29's pages in flight at once
+	BufMgr pool(num);
+	TaskScheduler io(4);
+	EventLoop loop(io);
+	int found = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (i = 0; i < num / 2; i++)
+		{
+			const PageId pageNo = pid[i];
+			const RecordId recordId = rid[i];
+			readPageAsync(loop, &pool, file4ptr, pageNo, LATCH_SHARED, [pageNo, recordId, &found](PageGuard page, std::exception_ptr error) {
+				char record[32];
+				sprintf(record, "test.4 Shard %u", pageNo);
+				if (error || page->getRecord(recordId) != record)
+				{
+					PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+				}
+				found++;
+			});
+		}
+		loop.run();
+	}
+	//the second pass hit every page
+	if (found != (int)num || pool.getBufStats().diskreads != (int)num / 2)
+	{
+		PRINT_ERROR("ERROR :: Async lookups did not read every page once");
+	}
+
+	//a failed read reaches the callback instead of the loop
+	bool failed = false;
+	readPageAsync(loop, &pool, file4ptr, 100000, LATCH_SHARED, [&failed](PageGuard page, std::exception_ptr error) {
+		try
+		{
+			std::rethrow_exception(error);
+		}
+		catch (const InvalidPageException &e)
+		{
+			failed = !page;
+		}
+	});
+	loop.run();
+	if (!failed)
+	{
+		PRINT_ERROR("ERROR :: Async read of an invalid page did not fail");
+	}
+
+	//a lookup waiting for a latch held by another lookup on the loop does not stall the loop
+	std::vector<int> order;
+	readPageAsync(loop, &pool, file4ptr, pid[0], LATCH_EXCLUSIVE, [&loop, &pool, &order](PageGuard page, std::exception_ptr error) {
+		if (error)
+		{
+			PRINT_ERROR("ERROR :: Async read of a cached page failed");
+		}
+		readPageAsync(loop, &pool, file4ptr, pid[0], LATCH_SHARED, [&order](PageGuard page, std::exception_ptr error) {
+			if (error || page.mode() != LATCH_SHARED)
+			{
+				PRINT_ERROR("ERROR :: Async read did not latch the page");
+			}
+			order.push_back(2);
+		});
+		const std::shared_ptr<PageGuard> held = std::make_shared<PageGuard>(std::move(page));
+		loop.post([held, &order]() {
+			order.push_back(1);
+			held->release();
+		});
+	});
+	loop.run();
+	if (order.size() != 2 || order[0] != 1 || order[1] != 2)
+	{
+		PRINT_ERROR("ERROR :: Contending async reads ran out of order");
+	}
+	pool.flushFile(file4ptr);
+
+	std::cout << "Test 33 passed" << "\n";
+}
+
+void test34()
+{
+	//a checkpoint writes a pinned dirty page and keeps it cached
+	BufMgr pool(num);
+	PageId pageNo;
+	RecordId recordId;
+	{
+		PageGuard guard = pool.allocPage(file4ptr, pageNo, LATCH_EXCLUSIVE);
+		recordId = guard->insertRecord("test.4 Checkpoint 0");
+		guard.markDirty();
+	}
+	{
+		PageGuard pinned = pool.readPage(file4ptr, pageNo);
+		pool.clearBufStats();
+		pool.flushFile(file4ptr, FLUSH_KEEP);
+		pool.flushFile(file4ptr, FLUSH_KEEP);
+		if (pool.getBufStats().diskwrites != 1)
+		{
+			PRINT_ERROR("ERROR :: Checkpoint did not write the dirty page exactly once");
+		}
+		if (file4ptr->readPage(pageNo).getRecord(recordId) != "test.4 Checkpoint 0")
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+	}
+	pool.readPage(file4ptr, pageNo);
+	if (pool.getBufStats().diskreads != 0)
+	{
+		PRINT_ERROR("ERROR :: Checkpoint evicted the page");
+	}
+
+	//checkpoints run while a writer and readers use the page
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> users;
+	users.push_back(std::thread([&pool, pageNo, recordId]() {
+		for (int j = 1; j <= 200; j++)
+		{
+			char record[32];
+			sprintf(record, "test.4 Checkpoint %d", j % 10);
+			PageGuard guard = pool.readPage(file4ptr, pageNo, LATCH_EXCLUSIVE);
+			guard->updateRecord(recordId, record);
+			guard.markDirty();
+		}
+	}));
+	for (int t = 0; t < 2; t++)
+	{
+		users.push_back(std::thread([&pool, &stop, pageNo, recordId]() {
+			while (!stop)
+			{
+				PageGuard guard = pool.readPage(file4ptr, pageNo, LATCH_SHARED);
+				if (guard->getRecord(recordId).compare(0, 18, "test.4 Checkpoint ") != 0)
+				{
+					PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+				}
+			}
+		}));
+	}
+	for (int j = 0; j < 50; j++)
+		pool.flushFile(file4ptr, FLUSH_KEEP);
+	users[0].join();
+	stop = true;
+	users[1].join();
+	users[2].join();
+
+	//the last checkpoint leaves the final version on disk
+	pool.flushFile(file4ptr, FLUSH_KEEP);
+	if (file4ptr->readPage(pageNo).getRecord(recordId) != "test.4 Checkpoint 0")
+	{
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	}
+
+	//a page a checkpoint fails to write stays dirty, so the next checkpoint tries it again
+	PageId lostNo;
+	{
+		PageGuard guard = pool.allocPage(file4ptr, lostNo);
+		guard->insertRecord("test.4 Checkpoint lost");
+		guard.markDirty();
+	}
+	file4ptr->deletePage(lostNo);
+	for (int j = 0; j < 2; j++)
+	{
+		try
+		{
+			pool.flushFile(file4ptr, FLUSH_KEEP);
+			PRINT_ERROR("ERROR :: Checkpoint wrote a deleted page");
+		}
+		catch (const InvalidPageException &e)
+		{
+		}
+	}
+	//and leaves no frame latched
+	pool.readPage(file4ptr, lostNo, LATCH_EXCLUSIVE);
+	try
+	{
+		pool.disposePage(file4ptr, lostNo);
+	}
+	catch (const InvalidPageException &e)
+	{
+	}
+	pool.flushFile(file4ptr);
+	pool.disposePage(file4ptr, pageNo);
+
+	std::cout << "Test 34 passed" << "\n";
+}
+
+void test35()
+{
+	//files with small and large pages share one buffer pool
+	const std::string& filename7 = "test.7";
+	const std::string& filename8 = "test.8";
+	try
+	{
+		File::remove(filename7);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+	try
+	{
+		File::remove(filename8);
+	}
+	catch(const FileNotFoundException &e)
+	{
+	}
+
+	try
+	{
+		File::create(filename7, false /* compress_pages */, 3000);
+		PRINT_ERROR("ERROR :: Page size is not a power of two. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const InvalidPageSizeException &e)
+	{
+	}
+
+	const std::size_t small = Page::MIN_SIZE * 8;
+	const std::size_t large = Page::MAX_SIZE;
+	std::vector<RecordId> smallRids, largeRids;
+	{
+		File file7 = File::create(filename7, false /* compress_pages */, small);
+		File file8 = File::create(filename8, true /* compress_pages */, large);
+		BufMgr pool(num, 1, 1, large);
+		HeapFile smallHeap(&pool, &file7);
+		HeapFile largeHeap(&pool, &file8);
+		for (i = 0; i < 20 * num; i++)
+		{
+			sprintf((char*)tmpbuf, "test.7 Sized %u", i);
+			smallRids.push_back(smallHeap.insert(tmpbuf));
+			largeRids.push_back(largeHeap.insert(tmpbuf));
+		}
+		if (smallHeap.num_pages() <= largeHeap.num_pages())
+		{
+			PRINT_ERROR("ERROR :: Small pages did not take more pages than large ones");
+		}
+		PageGuard guard = pool.readPage(&file7, smallRids[0].page_number);
+		if (guard->size() != small)
+		{
+			PRINT_ERROR("ERROR :: Page does not have its file's page size");
+		}
+		guard = pool.readPage(&file8, largeRids[0].page_number);
+		if (guard->size() != large)
+		{
+			PRINT_ERROR("ERROR :: Page does not have its file's page size");
+		}
+		guard.release();
+		pool.flushFile(&file7);
+		pool.flushFile(&file8);
+
+		//frames smaller than a file's pages cannot hold them
+		if (Page::DEFAULT_SIZE < large)
+		{
+			try
+			{
+				bufMgr->readPage(&file8, largeRids[0].page_number, page);
+				PRINT_ERROR("ERROR :: Pages are larger than the frames. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const InvalidPageSizeException &e)
+			{
+			}
+		}
+	}
+
+	{
+		File file7 = File::open(filename7);
+		File file8 = File::open(filename8);
+		if (file7.page_size() != small || file8.page_size() != large)
+		{
+			PRINT_ERROR("ERROR :: Reopened file has the wrong page size");
+		}
+		BufMgr pool(num, 1, 1, large);
+		HeapFile smallHeap(&pool, &file7);
+		HeapFile largeHeap(&pool, &file8);
+		for (i = 0; i < 20 * num; i++)
+		{
+			sprintf((char*)tmpbuf, "test.7 Sized %u", i);
+			if (smallHeap.get(smallRids[i]) != tmpbuf || largeHeap.get(largeRids[i]) != tmpbuf)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+		}
+		pool.flushFile(&file7);
+		pool.flushFile(&file8);
+	}
+	File::remove(filename7);
+	File::remove(filename8);
+
+	std::cout << "Test 35 passed" << "\n";
+}
+
+void test36()
+{
+	//fill a page with fixed-length records, then delete some and reuse their slots
+	bufMgr->allocPage(file3ptr, pageno3, page3);
+	FixedPage fixed(page3, 16);
+	fixed.initialize();
+	std::vector<RecordId> fixedRids;
+	for (i = 0; i < fixed.capacity(); i++)
+	{
+		sprintf((char*)tmpbuf, "test.3 Fix %05u", i);
+		fixedRids.push_back(fixed.insertRecord(std::string(tmpbuf, 16)));
+	}
+	try
+	{
+		fixed.insertRecord(std::string(tmpbuf, 16));
+		PRINT_ERROR("ERROR :: Page is full. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const InsufficientSpaceException &e)
+	{
+	}
+	bufMgr->unPinPage(file3ptr, pageno3, true);
+	bufMgr->flushFile(file3ptr);
+
+	bufMgr->readPage(file3ptr, pageno3, page3);
+	FixedPage reread(page3, 16);
+	for (i = 0; i < fixedRids.size(); i++)
+	{
+		sprintf((char*)tmpbuf, "test.3 Fix %05u", i);
+		if (reread.getRecordView(fixedRids[i]).toString() != std::string(tmpbuf, 16))
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+	}
+
+	//freed slots are handed out again, most recently freed first
+	reread.deleteRecord(fixedRids[5]);
+	reread.deleteRecord(fixedRids[9]);
+	try
+	{
+		reread.getRecordView(fixedRids[5]);
+		PRINT_ERROR("ERROR :: Record was deleted. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const InvalidRecordException &e)
+	{
+	}
+	if (reread.insertRecord("test.3 Fix again") != fixedRids[9] ||
+		reread.insertRecord("test.3 Fix other") != fixedRids[5] ||
+		reread.num_records() != reread.capacity())
+	{
+		PRINT_ERROR("ERROR :: Deleted slots were not reused");
+	}
+	bufMgr->unPinPage(file3ptr, pageno3, true);
+	bufMgr->flushFile(file3ptr);
+
+	bufMgr->readPage(file3ptr, pageno3, page3);
+	FixedPage reused(page3, 16);
+	if (reused.getRecordView(fixedRids[9]).toString() != "test.3 Fix again" ||
+		reused.getRecordView(fixedRids[5]).toString() != "test.3 Fix other")
+	{
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	}
+
+	//records too short to link free slots still reuse them
+	FixedPage bytes(page3, 1);
+	bytes.initialize();
+	const RecordId first = bytes.insertRecord("a");
+	bytes.insertRecord("b");
+	bytes.deleteRecord(first);
+	if (bytes.insertRecord("c") != first)
+	{
+		PRINT_ERROR("ERROR :: Deleted slots were not reused");
+	}
+	bufMgr->unPinPage(file3ptr, pageno3, true);
+	bufMgr->disposePage(file3ptr, pageno3);
+
+	std::cout << "Test 36 passed" << "\n";
+}
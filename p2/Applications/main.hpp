@@ -58,6 +58,16 @@
  *   $ make
  * @endcode
  *
+ * Every file has its own page size, given to <code>File::create</code> and
+ * recorded in the file, so that scan-heavy tables can use large pages and
+ * point-lookup tables small ones.  Files created without a page size get
+ * 8 KB pages; define <code>BADGERDB_PAGE_SIZE</code> (in bytes, a power of
+ * two) to change that default.  Pages of up to 64 KB are supported; define
+ * <code>BADGERDB_MAX_PAGE_SIZE</code> to allow larger ones:
+ * @code
+ *   $ make CFLAGS="-std=c++11 -Wall -DBADGERDB_MAX_PAGE_SIZE=262144"
+ * @endcode
+ *
  * @subsection modify_run_main_sec Modifying and running main
  *
  * To run the executable, first build the code, then run:
@@ -0,0 +1,131 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "numa.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Parses a sysfs list of CPUs or nodes such as "0-3,8-11" into numbers.
+ */
+std::vector<int> parseList(const std::string& list) {
+  std::vector<int> numbers;
+  std::stringstream ranges(list);
+  std::string range;
+  while (std::getline(ranges, range, ',')) {
+    int first = 0;
+    int last = 0;
+    char dash = 0;
+    std::stringstream bounds(range);
+    if (!(bounds >> first)) {
+      continue;
+    }
+    last = (bounds >> dash >> last) ? last : first;
+    for (int number = first; number <= last; ++number) {
+      numbers.push_back(number);
+    }
+  }
+  return numbers;
+}
+
+/**
+ * CPUs of every NUMA node, and the node of every CPU, read once.  Online
+ * node numbers may have gaps (say 0 and 2); nodes are indexed densely in the
+ * order they are listed.
+ */
+struct NumaTopology {
+  std::vector<std::vector<int> > node_cpus;
+  std::vector<std::uint32_t> cpu_node;
+
+  NumaTopology() {
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string nodes;
+    if (online && std::getline(online, nodes)) {
+      for (const int sysfs_node : parseList(nodes)) {
+        addNode(sysfs_node);
+      }
+    }
+    if (node_cpus.empty()) {
+      node_cpus.resize(1);
+    }
+  }
+
+  /**
+   * Adds the node sysfs numbers <sysfs_node>, if its CPUs can be read.
+   */
+  void addNode(const int sysfs_node) {
+    std::ifstream file("/sys/devices/system/node/node" +
+                       std::to_string(sysfs_node) + "/cpulist");
+    std::string list;
+    if (!file || !std::getline(file, list)) {
+      return;
+    }
+    const std::uint32_t node = node_cpus.size();
+    node_cpus.push_back(parseList(list));
+    for (const int cpu : node_cpus.back()) {
+      if (cpu_node.size() <= static_cast<std::size_t>(cpu)) {
+        cpu_node.resize(cpu + 1, 0);
+      }
+      cpu_node[cpu] = node;
+    }
+  }
+};
+
+const NumaTopology& topology() {
+  static const NumaTopology instance;
+  return instance;
+}
+
+}
+
+std::uint32_t numaNodeCount() {
+  return topology().node_cpus.size();
+}
+
+std::uint32_t currentNumaNode() {
+#ifdef __linux__
+  const int cpu = sched_getcpu();
+  const NumaTopology& numa = topology();
+  if (cpu >= 0 && static_cast<std::size_t>(cpu) < numa.cpu_node.size()) {
+    return numa.cpu_node[cpu];
+  }
+#endif
+  return 0;
+}
+
+bool runOnNumaNode(const std::uint32_t node) {
+#ifdef __linux__
+  const NumaTopology& numa = topology();
+  if (node >= numa.node_cpus.size() || numa.node_cpus[node].empty()) {
+    return false;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  for (const int cpu : numa.node_cpus[node]) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpus);
+    }
+  }
+  return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+  (void)node;
+  return false;
+#endif
+}
+
+}
@@ -0,0 +1,39 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * Returns the number of online NUMA nodes of the machine, read from sysfs.
+ * Returns 1 where the topology cannot be read.
+ *
+ * Nodes are numbered from 0 here even where the online nodes' own numbers
+ * have gaps: on a machine whose online nodes are 0 and 2, node 1 below is
+ * sysfs node 2.
+ */
+std::uint32_t numaNodeCount();
+
+/**
+ * Returns the NUMA node of the CPU the calling thread is running on, or 0
+ * where it cannot be found.  Cheap enough to call on every page access.
+ */
+std::uint32_t currentNumaNode();
+
+/**
+ * Restricts the calling thread to the CPUs of a NUMA node, so that memory it
+ * touches first is allocated on that node.
+ *
+ * @param node  Node to run on.
+ * @return  False if the thread could not be moved; it then runs as before.
+ */
+bool runOnNumaNode(const std::uint32_t node);
+
+}
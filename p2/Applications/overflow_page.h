@@ -0,0 +1,125 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Metadata stored at the start of the data area of an overflow page.
+ */
+struct OverflowHeader {
+  /**
+   * Number of the overflow page holding the next chunk of the value, or
+   * Page::INVALID_NUMBER if this is the last chunk.
+   */
+  PageId next_chunk;
+
+  /**
+   * Number of value bytes stored on this page.
+   */
+  std::uint32_t chunk_length;
+};
+
+/**
+ * @brief View which lays out a Page as one chunk of a large value.
+ *
+ * Values too large for a slotted page are split into chunks, each stored on
+ * its own overflow page, and the pages are chained through the OverflowHeader
+ * at the start of their data area.  As with PAX pages, the slotted page
+ * header describes an empty page with no free space, so file scans see no
+ * records on an overflow page, and records PAGE_FORMAT_OVERFLOW, which the
+ * accessors of each view check.
+ *
+ * @warning This class is not threadsafe.
+ */
+class OverflowPage {
+ public:
+  /**
+   * Returns the number of value bytes an overflow page of the given size can
+   * hold.
+   *
+   * @param page_size  Page size in bytes.
+   */
+  static std::size_t capacity(const std::size_t page_size) {
+    return page_size - sizeof(PageHeader) - sizeof(OverflowHeader);
+  }
+
+  /**
+   * Constructs an overflow view over the given page.  The page must outlive
+   * the view (typically it is pinned in the buffer pool).
+   *
+   * @param page  Page to view.
+   */
+  explicit OverflowPage(Page* page)
+      : page_(page) {
+    assert(page_ != NULL);
+  }
+
+  /**
+   * Formats the viewed page as an overflow page holding the given chunk.
+   *
+   * @param next_chunk  Page number of the next chunk, or
+   *                    Page::INVALID_NUMBER if this is the last one.
+   * @param data        First byte of the chunk.
+   * @param length      Length of the chunk; at most
+   *                    capacity(page->size()).
+   */
+  void initialize(const PageId next_chunk, const char* data,
+                  const std::size_t length) {
+    assert(length <= capacity(page_->size()));
+    const PageId page_number = page_->page_number();
+    const PageId next_page_number = page_->next_page_number();
+    page_->initialize();
+    page_->set_page_number(page_number);
+    page_->set_next_page_number(next_page_number);
+    page_->header_.free_space_lower_bound = page_->data_size();
+    page_->header_.free_space_upper_bound = page_->data_size();
+    page_->header_.format = PAGE_FORMAT_OVERFLOW;
+    OverflowHeader header = {next_chunk, static_cast<std::uint32_t>(length)};
+    std::memcpy(&page_->data_[0], &header, sizeof(header));
+    std::memcpy(&page_->data_[sizeof(header)], data, length);
+  }
+
+  /**
+   * Returns the page number of the next chunk, or Page::INVALID_NUMBER if
+   * this is the last one.
+   */
+  PageId next_chunk() const { return header().next_chunk; }
+
+  /**
+   * Returns a view of the chunk stored on this page.
+   */
+  RecordView chunk() const {
+    RecordView view = {&page_->data_[sizeof(OverflowHeader)],
+                       header().chunk_length};
+    return view;
+  }
+
+ private:
+  /**
+   * Returns the header stored at the start of the data area.
+   */
+  const OverflowHeader& header() const {
+    page_->checkFormat(PAGE_FORMAT_OVERFLOW);
+    return *reinterpret_cast<const OverflowHeader*>(&page_->data_[0]);
+  }
+
+  /**
+   * Page being viewed.
+   */
+  Page* page_;
+};
+
+}
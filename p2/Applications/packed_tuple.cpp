@@ -0,0 +1,71 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "packed_tuple.h"
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace badgerdb {
+
+PackedTupleBuilder::PackedTupleBuilder(const Schema& schema)
+    : schema_(&schema),
+      fixed_(schema),
+      nulls_((schema.num_columns() + 7) / 8, static_cast<char>(0xff)),
+      varchars_(schema.num_varchar_columns()) {
+}
+
+void PackedTupleBuilder::setNull(const std::size_t column) {
+  assert(column < schema_->num_columns());
+  nulls_[column / 8] |= static_cast<char>(1 << (column % 8));
+  if (schema_->column(column).type == VARCHAR) {
+    varchars_[schema_->column(column).offset].clear();
+  }
+}
+
+void PackedTupleBuilder::setVarchar(const std::size_t column,
+                                    const std::string& value) {
+  const Column& varchar_column = schema_->column(column);
+  assert(varchar_column.type == VARCHAR);
+  varchars_[varchar_column.offset] = value;
+  setPresent(column);
+}
+
+std::string PackedTupleBuilder::build() const {
+  std::string record = nulls_ + fixed_.data();
+  const std::size_t table = record.length();
+  record.append(varchars_.size() * sizeof(PageOffset), '\0');
+  for (std::size_t i = 0; i < varchars_.size(); ++i) {
+    record.append(varchars_[i]);
+    assert(record.length() <= std::numeric_limits<PageOffset>::max());
+    const PageOffset end = record.length();
+    std::memcpy(&record[table + i * sizeof(PageOffset)], &end, sizeof(end));
+  }
+  return record;
+}
+
+RecordView PackedTupleView::getVarchar(const std::size_t column) const {
+  const Column& varchar_column = schema_->column(column);
+  assert(varchar_column.type == VARCHAR);
+  const std::size_t index = varchar_column.offset;
+  const char* table = data_ + (schema_->num_columns() + 7) / 8 +
+      schema_->record_width();
+  PageOffset begin;
+  if (index == 0) {
+    begin = table - data_ + schema_->num_varchar_columns() * sizeof(PageOffset);
+  } else {
+    std::memcpy(&begin, table + (index - 1) * sizeof(PageOffset),
+                sizeof(begin));
+  }
+  PageOffset end;
+  std::memcpy(&end, table + index * sizeof(PageOffset), sizeof(end));
+  RecordView view = {data_ + begin, static_cast<std::size_t>(end - begin)};
+  return view;
+}
+
+}
@@ -0,0 +1,203 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "page.h"
+#include "schema.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Builds records with nullable and variable-width fields.
+ *
+ * A packed record has four parts:
+ *  - a null bitmap with one bit per column, set if the field is null;
+ *  - the fixed-width fields, at their Schema offsets, as in TupleBuilder;
+ *  - an offset table with the end offset (from the start of the record) of
+ *    every VARCHAR field, as PageOffset values;
+ *  - the VARCHAR field bytes, back to back.
+ * A null field costs its bit only, beyond the fixed-width slot that keeps
+ * the other offsets constant, and every field is found in O(1) from the
+ * schema and at most two offset table entries.
+ *
+ * Every field starts out null.  Setters must be called with the column's
+ * type.
+ */
+class PackedTupleBuilder {
+ public:
+  /**
+   * Constructs a builder for records of the given schema.
+   *
+   * @param schema  Schema of the record; must outlive the builder.
+   */
+  explicit PackedTupleBuilder(const Schema& schema);
+
+  /**
+   * Sets the field in the given column to null.
+   */
+  void setNull(const std::size_t column);
+
+  /**
+   * Sets the INT32 field in the given column.
+   */
+  void setInt32(const std::size_t column, const std::int32_t value) {
+    fixed_.setInt32(column, value);
+    setPresent(column);
+  }
+
+  /**
+   * Sets the INT64 field in the given column.
+   */
+  void setInt64(const std::size_t column, const std::int64_t value) {
+    fixed_.setInt64(column, value);
+    setPresent(column);
+  }
+
+  /**
+   * Sets the DOUBLE field in the given column.
+   */
+  void setDouble(const std::size_t column, const double value) {
+    fixed_.setDouble(column, value);
+    setPresent(column);
+  }
+
+  /**
+   * Sets the CHAR field in the given column.
+   */
+  void setChar(const std::size_t column, const std::string& value) {
+    fixed_.setChar(column, value);
+    setPresent(column);
+  }
+
+  /**
+   * Sets the VARCHAR field in the given column.
+   */
+  void setVarchar(const std::size_t column, const std::string& value);
+
+  /**
+   * Returns the bytes of the record built so far, ready to insert.
+   */
+  std::string build() const;
+
+ private:
+  /**
+   * Clears the null bit of the given column.
+   */
+  void setPresent(const std::size_t column) {
+    nulls_[column / 8] &= static_cast<char>(~(1 << (column % 8)));
+  }
+
+  /**
+   * Schema of the record.
+   */
+  const Schema* schema_;
+
+  /**
+   * Builder for the fixed-width fields.
+   */
+  TupleBuilder fixed_;
+
+  /**
+   * Null bitmap.
+   */
+  std::string nulls_;
+
+  /**
+   * Value of every VARCHAR field, by VARCHAR index.
+   */
+  std::vector<std::string> varchars_;
+};
+
+/**
+ * @brief Typed read access to the fields of a packed record, in place.
+ *
+ * As with TupleView, fields are read directly from the record bytes, so the
+ * view is only valid as long as those bytes are.  Accessors must be called
+ * with the column's type, and only for fields that are not null.
+ *
+ * @see PackedTupleBuilder
+ */
+class PackedTupleView {
+ public:
+  /**
+   * Constructs a view over a record built by PackedTupleBuilder.
+   *
+   * @param schema  Schema of the record; must outlive the view.
+   * @param record  Bytes of the record.
+   */
+  PackedTupleView(const Schema& schema, const RecordView& record)
+      : schema_(&schema),
+        data_(record.data),
+        fixed_(schema, record.data + (schema.num_columns() + 7) / 8) {
+  }
+
+  /**
+   * Returns true if the field in the given column is null.
+   */
+  bool isNull(const std::size_t column) const {
+    assert(column < schema_->num_columns());
+    return (data_[column / 8] >> (column % 8)) & 1;
+  }
+
+  /**
+   * Returns the INT32 field in the given column.
+   */
+  std::int32_t getInt32(const std::size_t column) const {
+    return fixed_.getInt32(column);
+  }
+
+  /**
+   * Returns the INT64 field in the given column.
+   */
+  std::int64_t getInt64(const std::size_t column) const {
+    return fixed_.getInt64(column);
+  }
+
+  /**
+   * Returns the DOUBLE field in the given column.
+   */
+  double getDouble(const std::size_t column) const {
+    return fixed_.getDouble(column);
+  }
+
+  /**
+   * Returns a view of the CHAR field in the given column, without its NUL
+   * padding.
+   */
+  RecordView getChar(const std::size_t column) const {
+    return fixed_.getChar(column);
+  }
+
+  /**
+   * Returns a view of the VARCHAR field in the given column.
+   */
+  RecordView getVarchar(const std::size_t column) const;
+
+ private:
+  /**
+   * Schema of the record.
+   */
+  const Schema* schema_;
+
+  /**
+   * First byte of the record.
+   */
+  const char* data_;
+
+  /**
+   * View of the fixed-width fields.
+   */
+  TupleView fixed_;
+};
+
+}
@@ -5,32 +5,93 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
+#include "bit_util.h"
 #include "exceptions/insufficient_space_exception.h"
 #include "exceptions/invalid_record_exception.h"
 #include "exceptions/invalid_slot_exception.h"
+#include "exceptions/page_format_exception.h"
 #include "exceptions/slot_in_use_exception.h"
 #include "page_iterator.h"
 #include "page.h"
 
 namespace badgerdb {
 
-Page::Page() {
+namespace {
+
+// Readers racing a writer load every field once, so a value checked is the
+// value used.  Under ThreadSanitizer their reads are also excluded from race
+// detection: the frame's version tells them afterwards whether a writer ran.
+#if defined(__SANITIZE_THREAD__)
+#define BADGERDB_TSAN 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define BADGERDB_TSAN 1
+#endif
+#endif
+
+#ifdef BADGERDB_TSAN
+extern "C" void AnnotateIgnoreReadsBegin(const char* file, int line);
+extern "C" void AnnotateIgnoreReadsEnd(const char* file, int line);
+#endif
+
+struct RacyReads {
+#ifdef BADGERDB_TSAN
+  RacyReads() { AnnotateIgnoreReadsBegin(__FILE__, __LINE__); }
+  ~RacyReads() { AnnotateIgnoreReadsEnd(__FILE__, __LINE__); }
+#else
+  RacyReads() {}
+#endif
+};
+
+template <typename T>
+T loadRelaxed(const T& value) {
+  return __atomic_load_n(&value, __ATOMIC_RELAXED);
+}
+
+}
+
+// Out-of-line definitions, for callers that bind these to references (as
+// std::make_pair and std::min do).
+const std::size_t Page::DEFAULT_SIZE;
+const std::size_t Page::MIN_SIZE;
+const std::size_t Page::MAX_SIZE;
+const PageId Page::INVALID_NUMBER;
+const SlotId Page::INVALID_SLOT;
+const std::size_t Page::INVALID_LENGTH;
+
+Page::Page() : Page(DEFAULT_SIZE) {}
+
+Page::Page(const std::size_t size)
+    : data_(size - sizeof(PageHeader), char()),
+      used_slots_((data_.size() / sizeof(PageSlot) + 63) / 64) {
+  assert(isValidSize(size));
   initialize();
 }
 
 void Page::initialize() {
   header_.free_space_lower_bound = 0;
-  header_.free_space_upper_bound = DATA_SIZE;
+  header_.free_space_upper_bound = data_.size();
   header_.num_slots = 0;
   header_.num_free_slots = 0;
+  header_.format = PAGE_FORMAT_SLOTTED;
   header_.current_page_number = INVALID_NUMBER;
   header_.next_page_number = INVALID_NUMBER;
-  data_.assign(DATA_SIZE, char());
+  header_.checksum = 0;
+  data_.assign(data_.size(), char());
+  std::fill(used_slots_.begin(), used_slots_.end(), std::uint64_t(0));
 }
 
 RecordId Page::insertRecord(const std::string& record_data) {
+  return insertRecord(record_data, PAGE_FORMAT_SLOTTED);
+}
+
+RecordId Page::insertRecord(const std::string& record_data,
+                            const PageFormat format) {
+  checkFormat(format);
   if (!hasSpaceForRecord(record_data)) {
     throw InsufficientSpaceException(
         page_number(), record_data.length(), getFreeSpace());
@@ -41,67 +102,119 @@ RecordId Page::insertRecord(const std::string& record_data) {
 }
 
 std::string Page::getRecord(const RecordId& record_id) const {
-  validateRecordId(record_id);
+  validateRecordId(record_id, PAGE_FORMAT_SLOTTED);
   const PageSlot& slot = getSlot(record_id.slot_number);
   return data_.substr(slot.item_offset, slot.item_length);
 }
 
+RecordView Page::getRecordView(const RecordId& record_id) const {
+  return getRecordView(record_id, PAGE_FORMAT_SLOTTED);
+}
+
+RecordView Page::getRecordView(const RecordId& record_id,
+                               const PageFormat format) const {
+  validateRecordId(record_id, format);
+  const PageSlot& slot = getSlot(record_id.slot_number);
+  RecordView view = {&data_[slot.item_offset], slot.item_length};
+  return view;
+}
+
+std::size_t Page::getRecord(const RecordId& record_id, char* out,
+                            const std::size_t capacity) const {
+  const RecordView view = getRecordView(record_id);
+  if (view.length <= capacity) {
+    std::memcpy(out, view.data, view.length);
+  }
+  return view.length;
+}
+
+std::size_t Page::getRecordOptimistic(const RecordId& record_id, char* out,
+                                      const std::size_t capacity) const {
+  RacyReads racy_reads;
+  if (loadRelaxed(header_.format) != PAGE_FORMAT_SLOTTED ||
+      loadRelaxed(header_.current_page_number) != record_id.page_number) {
+    return INVALID_LENGTH;
+  }
+  const std::size_t data_size = data_.size();
+  const SlotId num_slots = loadRelaxed(header_.num_slots);
+  if (record_id.slot_number == INVALID_SLOT ||
+      record_id.slot_number > num_slots ||
+      record_id.slot_number * sizeof(PageSlot) > data_size) {
+    return INVALID_LENGTH;
+  }
+  const PageSlot& slot = getSlot(record_id.slot_number);
+  if (!loadRelaxed(slot.used)) {
+    return INVALID_LENGTH;
+  }
+  const std::size_t offset = loadRelaxed(slot.item_offset);
+  const std::size_t length = loadRelaxed(slot.item_length);
+  if (offset > data_size || length > data_size - offset) {
+    return INVALID_LENGTH;
+  }
+  if (length <= capacity) {
+    const char* data = data_.data() + offset;
+    for (std::size_t i = 0; i < length; ++i) {
+      out[i] = loadRelaxed(data[i]);
+    }
+  }
+  return length;
+}
+
+std::size_t Page::copyRecords(const RecordId* record_ids,
+                              const std::size_t count, char* out,
+                              const std::size_t capacity,
+                              std::size_t* lengths) const {
+  std::size_t used = 0;
+  std::size_t copied = 0;
+  while (copied < count) {
+    const RecordView view = getRecordView(record_ids[copied]);
+    if (view.length > capacity - used) {
+      break;
+    }
+    std::memcpy(out + used, view.data, view.length);
+    used += view.length;
+    lengths[copied] = view.length;
+    ++copied;
+  }
+  return copied;
+}
+
 void Page::updateRecord(const RecordId& record_id,
                         const std::string& record_data) {
-  validateRecordId(record_id);
-  const PageSlot* slot = getSlot(record_id.slot_number);
+  validateRecordId(record_id, PAGE_FORMAT_SLOTTED);
+  PageSlot* slot = getSlot(record_id.slot_number);
   const std::size_t free_space_after_delete =
       getFreeSpace() + slot->item_length;
   if (record_data.length() > free_space_after_delete) {
     throw InsufficientSpaceException(
         page_number(), record_data.length(), free_space_after_delete);
   }
-  // We have to disallow slot compaction here because we're going to place the
-  // record data in the same slot, and compaction might delete the slot if we
-  // permit it.
-  deleteRecord(record_id, false /* allow_slot_compaction */);
-  insertRecordInSlot(record_id.slot_number, record_data);
+  // The slot stays used throughout, so the record never seems to be deleted.
+  removeRecordData(slot);
+  const PageOffset record_length = record_data.length();
+  slot->item_length = record_length;
+  slot->item_offset = header_.free_space_upper_bound - record_length;
+  header_.free_space_upper_bound = slot->item_offset;
+  data_.replace(slot->item_offset, record_length, record_data);
 }
 
 void Page::deleteRecord(const RecordId& record_id) {
-  deleteRecord(record_id, true /* allow_slot_compaction */);
+  deleteRecord(record_id, PAGE_FORMAT_SLOTTED);
 }
 
-void Page::deleteRecord(const RecordId& record_id,
-                        const bool allow_slot_compaction) {
-  validateRecordId(record_id);
+void Page::deleteRecord(const RecordId& record_id, const PageFormat format) {
+  validateRecordId(record_id, format);
   PageSlot* slot = getSlot(record_id.slot_number);
-  data_.replace(slot->item_offset, slot->item_length, slot->item_length, '\0');
-
-  // Compact the data by removing the hole left by this record (if necessary).
-  std::uint16_t move_offset = slot->item_offset; 
-  std::size_t move_bytes = 0;
-  for (SlotId i = 1; i <= header_.num_slots; ++i) {
-    PageSlot* other_slot = getSlot(i);
-    if (other_slot->used && other_slot->item_offset < slot->item_offset) {
-      if (other_slot->item_offset < move_offset) {
-        move_offset = other_slot->item_offset;
-      }
-      move_bytes += other_slot->item_length;
-      // Update the slot for the other data to reflect the soon-to-be-new
-      // location.
-      other_slot->item_offset += slot->item_length;
-    }
-  }
-  // If we have data to move, shift it to the right.
-  if (move_bytes > 0) {
-    const std::string& data_to_move = data_.substr(move_offset, move_bytes);
-    data_.replace(move_offset + slot->item_length, move_bytes, data_to_move);
-  }
-  header_.free_space_upper_bound += slot->item_length;
+  removeRecordData(slot);
 
   // Mark slot as unused.
   slot->used = false;
   slot->item_offset = 0;
   slot->item_length = 0;
+  setSlotUsed(record_id.slot_number, false);
   ++header_.num_free_slots;
 
-  if (allow_slot_compaction && record_id.slot_number == header_.num_slots) {
+  if (record_id.slot_number == header_.num_slots) {
     // Last slot in the list, so we need to free any unused slots that are at
     // the end of the slot list.
     int num_slots_to_delete = 1;
@@ -122,6 +235,33 @@ void Page::deleteRecord(const RecordId& record_id,
   }
 }
 
+void Page::removeRecordData(PageSlot* slot) {
+  data_.replace(slot->item_offset, slot->item_length, slot->item_length, '\0');
+
+  // Compact the data by removing the hole left by this record (if necessary).
+  PageOffset move_offset = slot->item_offset; 
+  std::size_t move_bytes = 0;
+  for (SlotId i = getNextUsedSlot(INVALID_SLOT, format()); i != INVALID_SLOT;
+       i = getNextUsedSlot(i, format())) {
+    PageSlot* other_slot = getSlot(i);
+    if (other_slot->item_offset < slot->item_offset) {
+      if (other_slot->item_offset < move_offset) {
+        move_offset = other_slot->item_offset;
+      }
+      move_bytes += other_slot->item_length;
+      // Update the slot for the other data to reflect the soon-to-be-new
+      // location.
+      other_slot->item_offset += slot->item_length;
+    }
+  }
+  // If we have data to move, shift it to the right.
+  if (move_bytes > 0) {
+    const std::string& data_to_move = data_.substr(move_offset, move_bytes);
+    data_.replace(move_offset + slot->item_length, move_bytes, data_to_move);
+  }
+  header_.free_space_upper_bound += slot->item_length;
+}
+
 bool Page::hasSpaceForRecord(const std::string& record_data) const {
   std::size_t record_size = record_data.length();
   if (header_.num_free_slots == 0) {
@@ -141,22 +281,22 @@ const PageSlot& Page::getSlot(const SlotId slot_number) const {
 SlotId Page::getAvailableSlot() {
   SlotId slot_number = INVALID_SLOT;
   if (header_.num_free_slots > 0) {
-    // Have an allocated but unused slot that we can reuse.
-    for (SlotId i = 1; i <= header_.num_slots; ++i) {
-      const PageSlot* slot = getSlot(i);
-      if (!slot->used) {
-        // We don't decrement the number of free slots until someone actually
-        // puts data in the slot.
-        slot_number = i;
-        break;
-      }
-    }
+    // Have an allocated but unused slot that we can reuse.  We don't
+    // decrement the number of free slots until someone actually puts data in
+    // the slot.
+    slot_number = findFirstClearBit(&used_slots_[0], header_.num_slots) + 1;
   } else {
     // Have to allocate a new slot.
     slot_number = header_.num_slots + 1;
     ++header_.num_slots;
     ++header_.num_free_slots;
     header_.free_space_lower_bound = sizeof(PageSlot) * header_.num_slots;
+    // The new slot overlaps what used to be free space, which may still hold
+    // stale record bytes left behind by compaction.
+    PageSlot* slot = getSlot(slot_number);
+    slot->used = false;
+    slot->item_offset = 0;
+    slot->item_length = 0;
   }
   assert(slot_number != INVALID_SLOT);
   return slot_number;
@@ -174,6 +314,7 @@ void Page::insertRecordInSlot(const SlotId slot_number,
   }
   const int record_length = record_data.length();
   slot->used = true;
+  setSlotUsed(slot_number, true);
   slot->item_length = record_length;
   slot->item_offset = header_.free_space_upper_bound - record_length;
   header_.free_space_upper_bound = slot->item_offset;
@@ -181,12 +322,59 @@ void Page::insertRecordInSlot(const SlotId slot_number,
   data_.replace(slot->item_offset, slot->item_length, record_data);
 }
 
-void Page::validateRecordId(const RecordId& record_id) const {
+SlotId Page::getNextUsedSlot(const SlotId start) const {
+  return getNextUsedSlot(start, PAGE_FORMAT_SLOTTED);
+}
+
+SlotId Page::getNextUsedSlot(const SlotId start,
+                             const PageFormat format) const {
+  if (header_.format != format) {
+    return INVALID_SLOT;
+  }
+  // Slot <start> + 1 lives at bit <start>.
+  const std::size_t bit = findNextSetBit(&used_slots_[0], header_.num_slots, start);
+  return bit < header_.num_slots ? bit + 1 : INVALID_SLOT;
+}
+
+void Page::setSize(const std::size_t size) {
+  assert(isValidSize(size));
+  data_.resize(size - sizeof(PageHeader));
+  used_slots_.resize((data_.size() / sizeof(PageSlot) + 63) / 64);
+}
+
+void Page::rebuildSlotMap() {
+  std::fill(used_slots_.begin(), used_slots_.end(), std::uint64_t(0));
+  // A damaged header must not send the scan past the data area.
+  if (header_.num_slots > data_.size() / sizeof(PageSlot)) {
+    header_.num_slots = data_.size() / sizeof(PageSlot);
+  }
+  for (SlotId i = 1; i <= header_.num_slots; ++i) {
+    if (getSlot(i)->used) {
+      setSlotUsed(i, true);
+    }
+  }
+}
+
+void Page::checkFormat(const PageFormat expected) const {
+  if (header_.format != expected) {
+    throw PageFormatException(page_number(), expected, header_.format);
+  }
+}
+
+void Page::validateRecordId(const RecordId& record_id,
+                            const PageFormat format) const {
+  checkFormat(format);
   if (record_id.page_number != page_number()) {
     throw InvalidRecordException(record_id, page_number());
   }
+  if (record_id.slot_number == INVALID_SLOT ||
+      record_id.slot_number > header_.num_slots) {
+    throw InvalidRecordException(record_id, page_number());
+  }
   const PageSlot& slot = getSlot(record_id.slot_number);
-  if (!slot.used) {
+  if (!slot.used ||
+      slot.item_offset + static_cast<std::size_t>(slot.item_length) >
+          data_.size()) {
     throw InvalidRecordException(record_id, page_number());
   }
 }
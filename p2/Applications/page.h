@@ -8,14 +8,84 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <stdint.h>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "types.h"
 
+/**
+ * Size in bytes of the pages of files created without an explicit page size.
+ * Every file records its own page size, so files of different page sizes can
+ * be used side by side; override the default at build time with
+ * -DBADGERDB_PAGE_SIZE=<bytes> (a power of two).
+ */
+#ifndef BADGERDB_PAGE_SIZE
+#define BADGERDB_PAGE_SIZE 8192
+#endif
+
+/**
+ * Largest page size supported by the build.  It decides the width of
+ * PageOffset, so pages larger than 64 KB require
+ * -DBADGERDB_MAX_PAGE_SIZE=<bytes> (a power of two).
+ */
+#ifndef BADGERDB_MAX_PAGE_SIZE
+#if BADGERDB_PAGE_SIZE > 65536
+#define BADGERDB_MAX_PAGE_SIZE BADGERDB_PAGE_SIZE
+#else
+#define BADGERDB_MAX_PAGE_SIZE 65536
+#endif
+#endif
+
 namespace badgerdb {
 
+/**
+ * @brief Offset or length of data within a page.
+ *
+ * Builds supporting pages of up to 64 KB address them with 16 bits; larger
+ * maximum page sizes widen every in-page offset (and thus PageHeader and
+ * PageSlot) to 32 bits.
+ */
+typedef std::conditional<(BADGERDB_MAX_PAGE_SIZE <= 65536),
+                         std::uint16_t, std::uint32_t>::type PageOffset;
+
+/**
+ * @brief Layout of the data area of a page.
+ *
+ * The format is recorded in the page header, so that a page written with one
+ * layout is never read with another.
+ */
+enum PageFormat {
+  /**
+   * Slot array and records, read through the Page API.
+   */
+  PAGE_FORMAT_SLOTTED = 0,
+
+  /**
+   * Column minipages; see PaxPage.
+   */
+  PAGE_FORMAT_PAX = 1,
+
+  /**
+   * One chunk of a large value; see OverflowPage.
+   */
+  PAGE_FORMAT_OVERFLOW = 2,
+
+  /**
+   * Records in key order; see SortedPage.
+   */
+  PAGE_FORMAT_SORTED = 3,
+
+  /**
+   * Slot array holding dictionary entries and encoded records; see DictPage.
+   */
+  PAGE_FORMAT_DICT = 4
+};
+
 /**
  * @brief Header metadata in a page.
  *
@@ -27,13 +97,13 @@ struct PageHeader {
    * Lower bound of the free space.  This is the offset of the first unused byte
    * after the slot array.
    */
-  std::uint16_t free_space_lower_bound;
+  PageOffset free_space_lower_bound;
 
   /**
    * Upper bound of the free space.  This is the offset of the last unused byte
    * before the first data record.
    */
-  std::uint16_t free_space_upper_bound;
+  PageOffset free_space_upper_bound;
 
   /**
    * Number of slots currently allocated.  This number may include slots which
@@ -47,6 +117,11 @@ struct PageHeader {
    */
   SlotId num_free_slots;
 
+  /**
+   * Layout of the data area, a PageFormat.
+   */
+  std::uint16_t format;
+
   /**
    * Number of the page within the file.
    */
@@ -57,6 +132,13 @@ struct PageHeader {
    */
   PageId next_page_number;
 
+  /**
+   * CRC32C of the header (with this field zeroed) and the used parts of the
+   * data area, set when the page is written to disk and verified when it is
+   * read back.
+   */
+  std::uint32_t checksum;
+
   /**
    * Returns true if this page header is equal to the other.
    *
@@ -66,6 +148,7 @@ struct PageHeader {
   bool operator==(const PageHeader& rhs) const {
     return num_slots == rhs.num_slots &&
         num_free_slots == rhs.num_free_slots &&
+        format == rhs.format &&
         current_page_number == rhs.current_page_number &&
         next_page_number == rhs.next_page_number;
   }
@@ -84,12 +167,34 @@ struct PageSlot {
   /**
    * Offset of the data item in the page.
    */
-  std::uint16_t item_offset;
+  PageOffset item_offset;
 
   /**
    * Length of the data item in this slot.
    */
-  std::uint16_t item_length;
+  PageOffset item_length;
+};
+
+/**
+ * @brief Read-only view of a record's bytes inside a page.
+ */
+struct RecordView {
+  /**
+   * First byte of the record.
+   */
+  const char* data;
+
+  /**
+   * Length of the record in bytes.
+   */
+  std::size_t length;
+
+  /**
+   * Returns a copy of the viewed bytes.
+   *
+   * @return  The record.
+   */
+  std::string toString() const { return std::string(data, length); }
 };
 
 class PageIterator;
@@ -102,20 +207,28 @@ class PageIterator;
  * slots and identified by a RecordId.  Although a record's actual contents may
  * be moved on the page, accessing a record by its slot is consistent.
  *
+ * The size of a page is chosen per file (see File::create()), between
+ * MIN_SIZE and MAX_SIZE: large pages suit scans, small pages point lookups.
+ *
  * @warning This class is not threadsafe.
  */
 class Page {
  public:
   /**
-   * Page size in bytes.  If this is changed, database files created with a
-   * different page size value will be unreadable by the resulting binaries.
+   * Size in bytes of the pages of files created without an explicit page
+   * size.
+   */
+  static const std::size_t DEFAULT_SIZE = BADGERDB_PAGE_SIZE;
+
+  /**
+   * Smallest supported page size in bytes.
    */
-  static const std::size_t SIZE = 8192;
+  static const std::size_t MIN_SIZE = 512;
 
   /**
-   * Size of page free space area in bytes.
+   * Largest supported page size in bytes.
    */
-  static const std::size_t DATA_SIZE = SIZE - sizeof(PageHeader);
+  static const std::size_t MAX_SIZE = BADGERDB_MAX_PAGE_SIZE;
 
   /**
    * Number of page indicating that it's invalid.
@@ -128,10 +241,32 @@ class Page {
   static const SlotId INVALID_SLOT = 0;
 
   /**
-   * Constructs a new, uninitialized page.
+   * Length returned by getRecordOptimistic() when there is no such record.
+   */
+  static const std::size_t INVALID_LENGTH = static_cast<std::size_t>(-1);
+
+  /**
+   * Returns true if pages of the given size are supported: a power of two
+   * between MIN_SIZE and MAX_SIZE.
+   *
+   * @param size  Page size in bytes.
+   */
+  static bool isValidSize(const std::size_t size) {
+    return size >= MIN_SIZE && size <= MAX_SIZE && (size & (size - 1)) == 0;
+  }
+
+  /**
+   * Constructs a new, uninitialized page of the default size.
    */
   Page();
 
+  /**
+   * Constructs a new, uninitialized page of the given size.
+   *
+   * @param size  Page size in bytes; must satisfy isValidSize().
+   */
+  explicit Page(const std::size_t size);
+
   /**
    * Inserts a new record into the page.
    *
@@ -144,12 +279,76 @@ class Page {
    * Returns the record with the given ID.  Returned data is a copy of what is
    * stored on the page; use updateRecord to change it.
    *
+   * Like every method taking a record ID, this throws PageFormatException if
+   * the page is not a slotted page.  Scans (begin(), getNextUsedSlot()) see no
+   * records on pages of other formats.
+   *
    * @see updateRecord
    * @param record_id  ID of the record to return.
    * @return  The record.
    */
   std::string getRecord(const RecordId& record_id) const;
 
+  /**
+   * Returns a view of the bytes of the record with the given ID without
+   * copying them.  The view points into the page and is invalidated by any
+   * change to the page (or, for buffered pages, by unpinning it).
+   *
+   * @see getRecord
+   * @param record_id  ID of the record to view.
+   * @return  View of the record.
+   */
+  RecordView getRecordView(const RecordId& record_id) const;
+
+  /**
+   * Copies the record with the given ID into a caller-owned buffer, so that
+   * callers reusing a buffer read records without any heap allocation.  If
+   * the record is longer than the buffer nothing is copied; the caller can
+   * compare the returned length with <capacity> and retry with a larger
+   * buffer.
+   *
+   * @param record_id  ID of the record to copy.
+   * @param out        Buffer to copy the record into.
+   * @param capacity   Length of the buffer in bytes.
+   * @return  Length of the record.
+   */
+  std::size_t getRecord(const RecordId& record_id, char* out,
+                        const std::size_t capacity) const;
+
+  /**
+   * Copies the record with the given ID like getRecord(), for readers that
+   * hold neither pin nor latch (see BufMgr::readPageOptimistic()) and may
+   * find the page half way through a change.  Whatever state the page is in,
+   * this never throws and never reads outside the page: every header and
+   * slot field is loaded once, atomically, and checked before it is used.
+   * What it returns is only meaningful if the frame's version is unchanged
+   * afterwards.
+   *
+   * @param record_id  ID of the record to copy.
+   * @param out        Buffer to copy the record into.
+   * @param capacity   Length of the buffer in bytes.
+   * @return  Length of the record, copied only if it fits in <capacity>, or
+   *          INVALID_LENGTH if the page holds no record with this ID.
+   */
+  std::size_t getRecordOptimistic(const RecordId& record_id, char* out,
+                                  const std::size_t capacity) const;
+
+  /**
+   * Copies records with the given IDs back to back into a caller-owned
+   * buffer, stopping at the first record that does not fit.
+   *
+   * @param record_ids  IDs of the records to copy.
+   * @param count       Number of record IDs.
+   * @param out         Buffer to copy the records into.
+   * @param capacity    Length of the buffer in bytes.
+   * @param lengths     Array of <count> entries, set to the length of every
+   *                    record copied.
+   * @return  Number of records copied.
+   */
+  std::size_t copyRecords(const RecordId* record_ids, const std::size_t count,
+                          char* out, const std::size_t capacity,
+                          std::size_t* lengths) const;
+
   /**
    * Updates the record with the given ID, replacing its data with a new
    * version.  This is equivalent to deleting the old record and inserting a
@@ -182,9 +381,42 @@ class Page {
    *
    * @return  Free space in bytes.
    */
-  std::uint16_t getFreeSpace() const { return header_.free_space_upper_bound -
+  PageOffset getFreeSpace() const { return header_.free_space_upper_bound -
                                               header_.free_space_lower_bound; }
 
+  /**
+   * Returns the size of this page in bytes, header included.
+   *
+   * @return  Page size in bytes.
+   */
+  std::size_t size() const { return sizeof(PageHeader) + data_.size(); }
+
+  /**
+   * Returns the size of this page's data area (everything but the header) in
+   * bytes.
+   *
+   * @return  Data area size in bytes.
+   */
+  std::size_t data_size() const { return data_.size(); }
+
+  /**
+   * Returns the layout of this page's data area.
+   *
+   * @return  Page format.
+   */
+  PageFormat format() const {
+    return static_cast<PageFormat>(header_.format);
+  }
+
+  /**
+   * Throws an exception unless this page has the given layout.  Views of
+   * other page formats call this before reading the page.
+   *
+   * @param expected  Format the caller is about to read the page as.
+   * @throws  PageFormatException  If the page has another format.
+   */
+  void checkFormat(const PageFormat expected) const;
+
   /**
    * Returns this page's number in its file.
    *
@@ -214,9 +446,33 @@ class Page {
    */
   PageIterator end();
 
+  /**
+   * Returns the next used slot in the page after the given slot or
+   * INVALID_SLOT if no slots are used after the given slot.  Uses the slot
+   * occupancy bitmap, so runs of unused slots are skipped a word at a time.
+   *
+   * @param start   Slot to start search at.
+   * @return  Next used slot after given slot or INVALID_SLOT.
+   */
+  SlotId getNextUsedSlot(const SlotId start) const;
+
  private:
+  /**
+   * Forms of the slotted record methods for views that keep their records in
+   * the slot array under a format of their own, such as DictPage.  Each throws
+   * PageFormatException unless the page has the given format, except
+   * getNextUsedSlot(), which then sees no records.
+   */
+  RecordId insertRecord(const std::string& record_data,
+                        const PageFormat format);
+  RecordView getRecordView(const RecordId& record_id,
+                           const PageFormat format) const;
+  void deleteRecord(const RecordId& record_id, const PageFormat format);
+  SlotId getNextUsedSlot(const SlotId start, const PageFormat format) const;
+
   /**
    * Initializes this page as a new page with no header information or data.
+   * The page keeps its size.
    */
   void initialize();
 
@@ -239,17 +495,13 @@ class Page {
   }
 
   /**
-   * Deletes the record with the given ID.  Page is compacted upon delete to
-   * ensure that data of all records is contiguous.  Slot array is compacted if
-   * the slot deleted is at the end of the slot array and
-   * <allow_slot_compaction> is set.
+   * Removes the data of the record in the given slot and compacts the page so
+   * that the data of all other records stays contiguous.  The slot itself is
+   * left as it is, still marked used, for the caller to reuse or free.
    *
-   * @param record_id             ID of the record to delete.
-   * @param allow_slot_compaction If true, the slot array will be compacted if
-   *                              possible.
+   * @param slot  Slot of the record whose data to remove.
    */
-  void deleteRecord(const RecordId& record_id,
-                    const bool allow_slot_compaction);
+  void removeRecordData(PageSlot* slot);
 
   /**
    * Returns the slot with the given number.  This method will return
@@ -303,15 +555,49 @@ class Page {
   void insertRecordInSlot(const SlotId slot_number,
                           const std::string& record_data);
 
+  /**
+   * Marks the given slot as used or unused in the slot occupancy bitmap.
+   *
+   * @param slot_number   Number of slot to update.
+   * @param used          Whether the slot now holds a record.
+   */
+  void setSlotUsed(const SlotId slot_number, const bool used) {
+    const std::size_t bit = slot_number - 1;
+    if (used) {
+      used_slots_[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    } else {
+      used_slots_[bit / 64] &= ~(std::uint64_t(1) << (bit % 64));
+    }
+  }
+
+  /**
+   * Changes the size of the page, keeping its storage: no memory is
+   * reallocated unless the page grows past the size it was constructed with.
+   * The contents are left for the caller to overwrite.
+   *
+   * @param size  Page size in bytes; must satisfy isValidSize().
+   */
+  void setSize(const std::size_t size);
+
+  /**
+   * Rebuilds the slot occupancy bitmap from the slot array.  Must be called
+   * whenever <data_> is replaced wholesale (e.g., when read from disk).
+   */
+  void rebuildSlotMap();
+
   /**
    * Throws an exception if the given record ID is not valid for this page
-   * (i.e., it has the right page number and the slot it references is in use).
+   * (i.e., it has the right page number and the slot it references is in use
+   * and lies within the page).
    *
    * @param record_id   Record ID to validate.
+   * @param format      Format the page must have.
    * @throws  InvalidRecordException  Thrown if the ID has a bad page or slot
    *                                  number.
+   * @throws  PageFormatException     Thrown if the page has another format.
    */
-  void validateRecordId(const RecordId& record_id) const;
+  void validateRecordId(const RecordId& record_id,
+                        const PageFormat format) const;
 
   /**
    * Returns whether the page is in use or is a free page.
@@ -332,15 +618,36 @@ class Page {
 
   std::string data_;
 
+  /**
+   * Occupancy bitmap of the slot array; bit i is set iff slot i + 1 is used.
+   * This is derived from <data_> and never written to disk.  Sized for the
+   * most slots the page could hold (every record empty).
+   */
+  std::vector<std::uint64_t> used_slots_;
+
   friend class File;
   friend class PageIterator;
+  friend class PaxPage;
+  friend class OverflowPage;
+  friend class SortedPage;
+  friend class DictPage;
   friend class PageTest;
   friend class BufferTest;
 };
 
-static_assert(Page::SIZE > sizeof(PageHeader),
+static_assert(Page::MIN_SIZE > sizeof(PageHeader),
               "Page size must be large enough to hold header and data.");
-static_assert(Page::DATA_SIZE > 0,
-              "Page must have some space to hold data.");
+static_assert((Page::DEFAULT_SIZE & (Page::DEFAULT_SIZE - 1)) == 0 &&
+                  (Page::MAX_SIZE & (Page::MAX_SIZE - 1)) == 0,
+              "Page sizes must be powers of two.");
+static_assert(Page::DEFAULT_SIZE >= Page::MIN_SIZE &&
+                  Page::DEFAULT_SIZE <= Page::MAX_SIZE,
+              "Default page size must be a supported page size.");
+static_assert(Page::MAX_SIZE - sizeof(PageHeader) <=
+                  std::numeric_limits<PageOffset>::max(),
+              "PageOffset must be able to address every byte of page data.");
+static_assert((Page::MAX_SIZE - sizeof(PageHeader)) / sizeof(PageSlot) <=
+                  std::numeric_limits<SlotId>::max(),
+              "SlotId must be able to number every slot a page can hold.");
 
 }
@@ -0,0 +1,111 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "page_latch.h"
+
+#include <climits>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Number of times an acquire retries before the thread parks.
+ */
+const int SPIN_LIMIT = 64;
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+}
+
+void PageLatch::lockSharedSlow() {
+  int spins = 0;
+  std::uint32_t state = state_.load(std::memory_order_relaxed);
+  while (true) {
+    if ((state & EXCLUSIVE) == 0) {
+      if (state_.compare_exchange_weak(state, state + 1,
+                                       std::memory_order_acquire)) {
+        return;
+      }
+      continue;
+    }
+    if (spins < SPIN_LIMIT) {
+      ++spins;
+      cpuRelax();
+      state = state_.load(std::memory_order_relaxed);
+      continue;
+    }
+    // Announce the wait while the holder still has the latch, so that its
+    // release is guaranteed to see the bit and wake us.
+    if ((state & WAITERS) == 0 &&
+        !state_.compare_exchange_weak(state, state | WAITERS,
+                                      std::memory_order_relaxed)) {
+      continue;
+    }
+    park(state | WAITERS);
+    state = state_.load(std::memory_order_relaxed);
+  }
+}
+
+void PageLatch::lockExclusiveSlow() {
+  int spins = 0;
+  std::uint32_t state = state_.load(std::memory_order_relaxed);
+  while (true) {
+    if ((state & (EXCLUSIVE | READERS)) == 0) {
+      // Keep the waiters bit: other parked threads still need a wakeup.
+      if (state_.compare_exchange_weak(state, state | EXCLUSIVE,
+                                       std::memory_order_acquire)) {
+        return;
+      }
+      continue;
+    }
+    if (spins < SPIN_LIMIT) {
+      ++spins;
+      cpuRelax();
+      state = state_.load(std::memory_order_relaxed);
+      continue;
+    }
+    if ((state & WAITERS) == 0 &&
+        !state_.compare_exchange_weak(state, state | WAITERS,
+                                      std::memory_order_relaxed)) {
+      continue;
+    }
+    park(state | WAITERS);
+    state = state_.load(std::memory_order_relaxed);
+  }
+}
+
+void PageLatch::park(const std::uint32_t expected) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&state_),
+          FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#else
+  (void)expected;
+  std::this_thread::yield();
+#endif
+}
+
+void PageLatch::wakeWaiters() {
+  state_.fetch_and(~WAITERS, std::memory_order_relaxed);
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&state_),
+          FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+}
@@ -0,0 +1,234 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * @brief Mode in which a pinned page is latched.
+ */
+enum LatchMode {
+  /**
+   * Pin only; the caller synchronizes access to the page itself.
+   */
+  LATCH_NONE,
+
+  /**
+   * Shared latch; any number of threads may read the page at once.
+   */
+  LATCH_SHARED,
+
+  /**
+   * Exclusive latch; the holder is the only thread accessing the page.
+   */
+  LATCH_EXCLUSIVE
+};
+
+/**
+ * @brief Reader/writer latch held in a single 32-bit word.
+ *
+ * The word holds the number of shared holders, a bit set while the latch is
+ * held exclusively and a bit set while some thread is parked waiting for it.
+ * Acquiring spins briefly and then parks the thread (on a futex on Linux,
+ * by yielding elsewhere), so an uncontended acquire or release is a single
+ * atomic operation and waiting threads do not burn a core.
+ *
+ * Shared holders are admitted while the latch is not held exclusively, so a
+ * steady stream of readers can delay a writer.
+ */
+class PageLatch {
+ public:
+  PageLatch() : state_(0) {}
+
+  PageLatch(const PageLatch&) = delete;
+  PageLatch& operator=(const PageLatch&) = delete;
+
+  /**
+   * Acquires the latch in shared mode, waiting while it is held exclusively.
+   */
+  void lockShared() {
+    std::uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & EXCLUSIVE) != 0 ||
+        !state_.compare_exchange_weak(state, state + 1,
+                                      std::memory_order_acquire)) {
+      lockSharedSlow();
+    }
+  }
+
+  /**
+   * Releases a shared hold on the latch.
+   */
+  void unlockShared() {
+    const std::uint32_t prev = state_.fetch_sub(1, std::memory_order_release);
+    if ((prev & READERS) == 1 && (prev & WAITERS) != 0) {
+      wakeWaiters();
+    }
+  }
+
+  /**
+   * Acquires the latch in exclusive mode, waiting while it has any holder.
+   */
+  void lockExclusive() {
+    std::uint32_t state = 0;
+    if (!state_.compare_exchange_weak(state, EXCLUSIVE,
+                                      std::memory_order_acquire)) {
+      lockExclusiveSlow();
+    }
+  }
+
+  /**
+   * Releases an exclusive hold on the latch.
+   */
+  void unlockExclusive() {
+    const std::uint32_t prev =
+        state_.fetch_and(~EXCLUSIVE, std::memory_order_release);
+    if ((prev & WAITERS) != 0) {
+      wakeWaiters();
+    }
+  }
+
+  /**
+   * Acquires the latch in the given mode; does nothing for LATCH_NONE.
+   */
+  void lock(const LatchMode mode) {
+    if (mode == LATCH_SHARED) {
+      lockShared();
+    } else if (mode == LATCH_EXCLUSIVE) {
+      lockExclusive();
+    }
+  }
+
+  /**
+   * Acquires the latch in shared mode if it is not held exclusively, without
+   * waiting.
+   *
+   * @return  True if the latch was acquired.
+   */
+  bool tryLockShared() {
+    std::uint32_t state = state_.load(std::memory_order_relaxed);
+    while ((state & EXCLUSIVE) == 0) {
+      if (state_.compare_exchange_weak(state, state + 1,
+                                       std::memory_order_acquire)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Acquires the latch in exclusive mode if it has no holder, without
+   * waiting.
+   *
+   * @return  True if the latch was acquired.
+   */
+  bool tryLockExclusive() {
+    std::uint32_t state = state_.load(std::memory_order_relaxed);
+    while ((state & (EXCLUSIVE | READERS)) == 0) {
+      if (state_.compare_exchange_weak(state, state | EXCLUSIVE,
+                                       std::memory_order_acquire)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Acquires the latch in the given mode if that needs no waiting; always
+   * succeeds for LATCH_NONE.
+   *
+   * @return  True if the latch was acquired.
+   */
+  bool tryLock(const LatchMode mode) {
+    if (mode == LATCH_SHARED) {
+      return tryLockShared();
+    } else if (mode == LATCH_EXCLUSIVE) {
+      return tryLockExclusive();
+    }
+    return true;
+  }
+
+  /**
+   * Releases a hold in the given mode; does nothing for LATCH_NONE.
+   */
+  void unlock(const LatchMode mode) {
+    if (mode == LATCH_SHARED) {
+      unlockShared();
+    } else if (mode == LATCH_EXCLUSIVE) {
+      unlockExclusive();
+    }
+  }
+
+  /**
+   * Returns true if the latch is held in either mode.
+   */
+  bool isLocked() const {
+    return (state_.load(std::memory_order_relaxed) & (EXCLUSIVE | READERS)) !=
+           0;
+  }
+
+ private:
+  /**
+   * Bit set while the latch is held exclusively.
+   */
+  static const std::uint32_t EXCLUSIVE = 1u << 31;
+
+  /**
+   * Bit set while at least one thread is parked on the latch.
+   */
+  static const std::uint32_t WAITERS = 1u << 30;
+
+  /**
+   * Bits counting the shared holders.
+   */
+  static const std::uint32_t READERS = WAITERS - 1;
+
+  void lockSharedSlow();
+  void lockExclusiveSlow();
+
+  /**
+   * Parks the calling thread until the latch word changes from <expected>.
+   * May return early.
+   */
+  void park(const std::uint32_t expected);
+
+  /**
+   * Clears the waiters bit and wakes every parked thread.
+   */
+  void wakeWaiters();
+
+  std::atomic<std::uint32_t> state_;
+};
+
+/**
+ * @brief Hold on a PageLatch that is released when the object goes out of
+ * scope, like std::lock_guard.
+ */
+class ScopedLatch {
+ public:
+  /**
+   * Acquires <latch> in the given mode, waiting if needed.
+   */
+  ScopedLatch(PageLatch& latch, const LatchMode mode)
+      : latch_(latch), mode_(mode) {
+    latch_.lock(mode_);
+  }
+
+  ScopedLatch(const ScopedLatch&) = delete;
+  ScopedLatch& operator=(const ScopedLatch&) = delete;
+
+  ~ScopedLatch() { latch_.unlock(mode_); }
+
+ private:
+  PageLatch& latch_;
+  const LatchMode mode_;
+};
+
+}
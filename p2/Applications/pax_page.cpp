@@ -0,0 +1,200 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "pax_page.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+#include "bit_util.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_record_exception.h"
+#include "exceptions/invalid_record_length_exception.h"
+
+namespace badgerdb {
+
+static_assert(sizeof(PaxHeader) <= 8,
+              "PAX header must fit before the presence bitmap.");
+
+PaxPage::PaxPage(Page* page, const std::vector<std::size_t>& column_widths)
+    : page_(page),
+      column_widths_(column_widths),
+      record_width_(0),
+      capacity_(0) {
+  assert(page_ != NULL);
+  assert(!column_widths_.empty());
+  for (std::size_t i = 0; i < column_widths_.size(); ++i) {
+    record_width_ += column_widths_[i];
+  }
+  assert(record_width_ > 0);
+
+  // Find the largest number of records whose bitmap and minipages fit in the
+  // data area.
+  const std::size_t data_size = page_->data_size();
+  std::size_t capacity = (data_size - PRESENCE_OFFSET) / record_width_;
+  while (capacity > 0 &&
+         PRESENCE_OFFSET + (capacity + 63) / 64 * 8 +
+             capacity * record_width_ > data_size) {
+    --capacity;
+  }
+  if (capacity > std::numeric_limits<SlotId>::max()) {
+    capacity = std::numeric_limits<SlotId>::max();
+  }
+  capacity_ = capacity;
+
+  std::size_t offset = PRESENCE_OFFSET + (capacity_ + 63) / 64 * 8;
+  for (std::size_t i = 0; i < column_widths_.size(); ++i) {
+    column_offsets_.push_back(offset);
+    offset += capacity_ * column_widths_[i];
+  }
+}
+
+void PaxPage::initialize() {
+  const PageId page_number = page_->page_number();
+  const PageId next_page_number = page_->next_page_number();
+  page_->initialize();
+  page_->set_page_number(page_number);
+  page_->set_next_page_number(next_page_number);
+  // Leave no free space for the slotted page API.
+  page_->header_.free_space_lower_bound = page_->data_size();
+  page_->header_.free_space_upper_bound = page_->data_size();
+  page_->header_.format = PAGE_FORMAT_PAX;
+  header().num_slots = 0;
+  header().num_free_slots = 0;
+  header().first_free_slot = Page::INVALID_SLOT;
+}
+
+RecordId PaxPage::insertRecord(const std::string& record_data) {
+  page_->checkFormat(PAGE_FORMAT_PAX);
+  validateLength(record_data);
+  PaxHeader& pax_header = header();
+  SlotId slot_number;
+  if (pax_header.num_free_slots > 0 && hasFreeList()) {
+    // Pop the free list; the slot holds the number of the next free slot.
+    slot_number = pax_header.first_free_slot;
+    readFields(slot_number,
+               reinterpret_cast<char*>(&pax_header.first_free_slot),
+               sizeof(SlotId));
+    --pax_header.num_free_slots;
+  } else if (pax_header.num_free_slots > 0) {
+    slot_number = findFirstClearBit(presence(), pax_header.num_slots) + 1;
+    --pax_header.num_free_slots;
+  } else if (pax_header.num_slots < capacity_) {
+    slot_number = ++pax_header.num_slots;
+  } else {
+    throw InsufficientSpaceException(
+        page_->page_number(), record_data.length(), 0 /* available */);
+  }
+  const std::size_t bit = slot_number - 1;
+  presence()[bit / 64] |= std::uint64_t(1) << (bit % 64);
+  writeFields(slot_number, record_data.data(), record_width_);
+  return {page_->page_number(), slot_number};
+}
+
+std::string PaxPage::getRecord(const RecordId& record_id) const {
+  validateRecordId(record_id);
+  std::string record_data(record_width_, '\0');
+  readFields(record_id.slot_number, &record_data[0], record_width_);
+  return record_data;
+}
+
+std::string PaxPage::getField(const RecordId& record_id,
+                              const std::size_t column) const {
+  validateRecordId(record_id);
+  return page_->data_.substr(fieldOffset(record_id.slot_number, column),
+                             column_widths_[column]);
+}
+
+void PaxPage::updateRecord(const RecordId& record_id,
+                           const std::string& record_data) {
+  validateRecordId(record_id);
+  validateLength(record_data);
+  writeFields(record_id.slot_number, record_data.data(), record_width_);
+}
+
+void PaxPage::deleteRecord(const RecordId& record_id) {
+  validateRecordId(record_id);
+  PaxHeader& pax_header = header();
+  const std::size_t bit = record_id.slot_number - 1;
+  presence()[bit / 64] &= ~(std::uint64_t(1) << (bit % 64));
+  ++pax_header.num_free_slots;
+  if (hasFreeList()) {
+    // Push the slot onto the free list.
+    writeFields(record_id.slot_number,
+                reinterpret_cast<const char*>(&pax_header.first_free_slot),
+                sizeof(SlotId));
+    pax_header.first_free_slot = record_id.slot_number;
+  }
+}
+
+bool PaxPage::isUsed(const SlotId slot_number) const {
+  page_->checkFormat(PAGE_FORMAT_PAX);
+  if (slot_number == Page::INVALID_SLOT ||
+      slot_number > header().num_slots) {
+    return false;
+  }
+  const std::size_t bit = slot_number - 1;
+  return (presence()[bit / 64] >> (bit % 64)) & 1;
+}
+
+SlotId PaxPage::getNextUsedSlot(const SlotId start) const {
+  page_->checkFormat(PAGE_FORMAT_PAX);
+  const std::size_t num_slots = header().num_slots;
+  const std::size_t bit = findNextSetBit(presence(), num_slots, start);
+  return bit < num_slots ? bit + 1 : Page::INVALID_SLOT;
+}
+
+PaxColumnIterator PaxPage::columnBegin(const std::size_t column) const {
+  return PaxColumnIterator(this, column,
+                           getNextUsedSlot(Page::INVALID_SLOT /* start */));
+}
+
+PaxColumnIterator PaxPage::columnEnd(const std::size_t column) const {
+  return PaxColumnIterator(this, column, Page::INVALID_SLOT);
+}
+
+void PaxPage::writeFields(const SlotId slot_number, const char* record_data,
+                          const std::size_t length) {
+  std::size_t record_offset = 0;
+  for (std::size_t i = 0; record_offset < length; ++i) {
+    const std::size_t field_length =
+        std::min(column_widths_[i], length - record_offset);
+    std::memcpy(&page_->data_[fieldOffset(slot_number, i)],
+                record_data + record_offset, field_length);
+    record_offset += field_length;
+  }
+}
+
+void PaxPage::readFields(const SlotId slot_number, char* out,
+                         const std::size_t length) const {
+  std::size_t record_offset = 0;
+  for (std::size_t i = 0; record_offset < length; ++i) {
+    const std::size_t field_length =
+        std::min(column_widths_[i], length - record_offset);
+    std::memcpy(out + record_offset,
+                &page_->data_[fieldOffset(slot_number, i)], field_length);
+    record_offset += field_length;
+  }
+}
+
+void PaxPage::validateLength(const std::string& record_data) const {
+  if (record_data.length() != record_width_) {
+    throw InvalidRecordLengthException(
+        page_->page_number(), record_width_, record_data.length());
+  }
+}
+
+void PaxPage::validateRecordId(const RecordId& record_id) const {
+  if (record_id.page_number != page_->page_number() ||
+      !isUsed(record_id.slot_number)) {
+    throw InvalidRecordException(record_id, page_->page_number());
+  }
+}
+
+}
@@ -0,0 +1,399 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+class PaxColumnIterator;
+
+/**
+ * @brief Metadata stored at the start of the data area of a PAX page.
+ */
+struct PaxHeader {
+  /**
+   * Number of slots currently allocated, including unused slots in the
+   * middle of the page (due to record deletions).
+   */
+  SlotId num_slots;
+
+  /**
+   * Number of slots allocated but not in use.
+   */
+  SlotId num_free_slots;
+
+  /**
+   * First slot of the list of slots allocated but not in use, or
+   * Page::INVALID_SLOT if it is empty.  Each free slot holds the number of
+   * the next in the first bytes of its record.  Unused when records are
+   * shorter than a SlotId.
+   */
+  SlotId first_free_slot;
+};
+
+/**
+ * @brief View which lays out a Page as PAX (partition attributes across)
+ *        minipages.
+ *
+ * Records on a PAX page have a fixed schema: a list of column widths in
+ * bytes.  Rather than storing each record contiguously, the data area of the
+ * page is split into one minipage per column, so the values of a single
+ * column for all records on the page are contiguous in memory.  A scan that
+ * reads one column therefore touches only that column's bytes.
+ *
+ * The data area holds a PaxHeader, a presence bitmap (one bit per slot) and
+ * then the minipages.  Deleted slots are kept on a free list threaded
+ * through their record bytes, so inserts reuse them in constant time.  Record IDs are (page number, slot) as for slotted
+ * pages, and slots are 1-based.  The slotted page header describes an empty
+ * page with no free space, so the slotted Page API sees no records on a PAX
+ * page and refuses to insert any.
+ *
+ * initialize() records PAGE_FORMAT_PAX in the page header, and every other
+ * method throws PageFormatException on a page of another format.  The
+ * schema is not recorded; callers must always view a file's pages with the
+ * same column widths.
+ *
+ * @warning This class is not threadsafe.
+ */
+class PaxPage {
+ public:
+  /**
+   * Constructs a PAX view over the given page.  The page must outlive the
+   * view (typically it is pinned in the buffer pool).
+   *
+   * @param page            Page to view.
+   * @param column_widths   Width in bytes of each column, in record order.
+   */
+  PaxPage(Page* page, const std::vector<std::size_t>& column_widths);
+
+  /**
+   * Formats the viewed page as an empty PAX page.  Must be called once on a
+   * newly allocated page before records are inserted.
+   */
+  void initialize();
+
+  /**
+   * Inserts a new record into the page.  Record length must equal the sum of
+   * the column widths.
+   *
+   * @param record_data  Bytes that compose the record.
+   * @return  ID of the newly inserted record.
+   * @throws  InvalidRecordLengthException  If the record has the wrong length.
+   * @throws  InsufficientSpaceException    If every slot is in use.
+   */
+  RecordId insertRecord(const std::string& record_data);
+
+  /**
+   * Returns a copy of the record with the given ID, reassembled from its
+   * columns.
+   *
+   * @param record_id  ID of the record to return.
+   * @return  The record.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  std::string getRecord(const RecordId& record_id) const;
+
+  /**
+   * Returns a copy of a single field of the record with the given ID.
+   *
+   * @param record_id  ID of the record.
+   * @param column     Column number of the field.
+   * @return  The field bytes.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  std::string getField(const RecordId& record_id,
+                       const std::size_t column) const;
+
+  /**
+   * Replaces the data of the record with the given ID in place.
+   *
+   * @param record_id   ID of record to update.
+   * @param record_data Updated bytes that compose the record.
+   * @throws  InvalidRecordException        If the ID does not refer to a
+   *                                        record.
+   * @throws  InvalidRecordLengthException  If the record has the wrong length.
+   */
+  void updateRecord(const RecordId& record_id, const std::string& record_data);
+
+  /**
+   * Deletes the record with the given ID.  Its slot is reused by the next
+   * insert.
+   *
+   * @param record_id   ID of the record to delete.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  void deleteRecord(const RecordId& record_id);
+
+  /**
+   * Returns the number of the viewed page in its file.
+   */
+  PageId page_number() const { return page_->page_number(); }
+
+  /**
+   * Returns the number of records the page can hold.
+   */
+  std::size_t capacity() const { return capacity_; }
+
+  /**
+   * Returns the number of records currently on the page.
+   */
+  std::size_t num_records() const {
+    return header().num_slots - header().num_free_slots;
+  }
+
+  /**
+   * Returns the number of columns in the schema.
+   */
+  std::size_t num_columns() const { return column_widths_.size(); }
+
+  /**
+   * Returns the width in bytes of the given column.
+   */
+  std::size_t column_width(const std::size_t column) const {
+    return column_widths_[column];
+  }
+
+  /**
+   * Returns the minipage of the given column.  The value of that column for
+   * slot s is at column_data(column) + (s - 1) * column_width(column); slots
+   * that are not in use hold unspecified bytes.
+   *
+   * @param column  Column number.
+   * @return  Pointer to the first byte of the column's minipage.
+   */
+  const char* column_data(const std::size_t column) const {
+    return &page_->data_[column_offsets_[column]];
+  }
+
+  /**
+   * Returns true if the given slot holds a record.
+   */
+  bool isUsed(const SlotId slot_number) const;
+
+  /**
+   * Returns the next used slot in the page after the given slot or
+   * Page::INVALID_SLOT if no slots are used after the given slot.
+   *
+   * @param start   Slot to start search at.
+   * @return  Next used slot after given slot or Page::INVALID_SLOT.
+   */
+  SlotId getNextUsedSlot(const SlotId start) const;
+
+  /**
+   * Returns an iterator over the values of a column, starting at the first
+   * record in the page.
+   *
+   * @param column  Column number.
+   * @return  Iterator at the first record's value.
+   */
+  PaxColumnIterator columnBegin(const std::size_t column) const;
+
+  /**
+   * Returns an iterator representing the value after the last record's value
+   * in a column.  This iterator should not be dereferenced.
+   *
+   * @param column  Column number.
+   * @return  Iterator past the last record's value.
+   */
+  PaxColumnIterator columnEnd(const std::size_t column) const;
+
+ private:
+  /**
+   * Offset of the presence bitmap within the data area; keeps it 8-byte
+   * aligned.
+   */
+  static const std::size_t PRESENCE_OFFSET = 8;
+
+  /**
+   * Returns the header stored at the start of the data area.
+   */
+  PaxHeader& header() {
+    return *reinterpret_cast<PaxHeader*>(&page_->data_[0]);
+  }
+
+  /**
+   * Returns the header stored at the start of the data area.
+   */
+  const PaxHeader& header() const {
+    return *reinterpret_cast<const PaxHeader*>(&page_->data_[0]);
+  }
+
+  /**
+   * Returns the presence bitmap stored after the header.
+   */
+  std::uint64_t* presence() {
+    return reinterpret_cast<std::uint64_t*>(&page_->data_[PRESENCE_OFFSET]);
+  }
+
+  /**
+   * Returns the presence bitmap stored after the header.
+   */
+  const std::uint64_t* presence() const {
+    return reinterpret_cast<const std::uint64_t*>(
+        &page_->data_[PRESENCE_OFFSET]);
+  }
+
+  /**
+   * Returns the offset within the data area of a field of the given slot.
+   *
+   * @param slot_number   Slot holding the field.
+   * @param column        Column number of the field.
+   * @return  Offset of the field.
+   */
+  std::size_t fieldOffset(const SlotId slot_number,
+                          const std::size_t column) const {
+    return column_offsets_[column] + (slot_number - 1) * column_widths_[column];
+  }
+
+  /**
+   * Copies the first <length> bytes of a record into their minipages.
+   *
+   * @param slot_number   Slot to write.
+   * @param record_data   Bytes that compose the record.
+   * @param length        Number of bytes to write; at most the record width.
+   */
+  void writeFields(const SlotId slot_number, const char* record_data,
+                   const std::size_t length);
+
+  /**
+   * Copies the first <length> bytes of a record out of its minipages.
+   *
+   * @param slot_number   Slot to read.
+   * @param out           Buffer to copy the record bytes into.
+   * @param length        Number of bytes to read; at most the record width.
+   */
+  void readFields(const SlotId slot_number, char* out,
+                  const std::size_t length) const;
+
+  /**
+   * Returns true if free slots are kept on the free list, i.e. if a record
+   * is long enough to hold the link to the next free slot.
+   */
+  bool hasFreeList() const { return record_width_ >= sizeof(SlotId); }
+
+  /**
+   * Throws an exception if the given record has the wrong length.
+   *
+   * @param record_data   Bytes that compose the record.
+   * @throws  InvalidRecordLengthException  If the record has the wrong length.
+   */
+  void validateLength(const std::string& record_data) const;
+
+  /**
+   * Throws an exception if the given record ID does not refer to a record on
+   * this page.
+   *
+   * @param record_id   Record ID to validate.
+   * @throws  InvalidRecordException  If the ID has a bad page or slot number.
+   */
+  void validateRecordId(const RecordId& record_id) const;
+
+  /**
+   * Page being viewed.
+   */
+  Page* page_;
+
+  /**
+   * Width in bytes of each column.
+   */
+  std::vector<std::size_t> column_widths_;
+
+  /**
+   * Offset of each column's minipage within the data area.
+   */
+  std::vector<std::size_t> column_offsets_;
+
+  /**
+   * Sum of the column widths.
+   */
+  std::size_t record_width_;
+
+  /**
+   * Number of records the page can hold.
+   */
+  std::size_t capacity_;
+};
+
+/**
+ * @brief Iterator over the values of one column of a PaxPage.
+ *
+ * Dereferencing yields a pointer to the value bytes inside the page, so a
+ * column scan never copies or touches the other columns.
+ */
+class PaxColumnIterator {
+ public:
+  /**
+   * Constructs an iterator over the given column, positioned at the given
+   * slot.
+   *
+   * @param page    PAX page to iterate over.
+   * @param column  Column number.
+   * @param slot    Slot to start at; Page::INVALID_SLOT for the end.
+   */
+  PaxColumnIterator(const PaxPage* page, const std::size_t column,
+                    const SlotId slot)
+      : page_(page),
+        column_(column),
+        slot_(slot) {
+    assert(page_ != NULL);
+  }
+
+  /**
+   * Advances the iterator to the next record's value.
+   */
+  inline PaxColumnIterator& operator++() {
+    slot_ = page_->getNextUsedSlot(slot_);
+    return *this;
+  }
+
+  inline bool operator==(const PaxColumnIterator& rhs) const {
+    return page_ == rhs.page_ && column_ == rhs.column_ && slot_ == rhs.slot_;
+  }
+
+  inline bool operator!=(const PaxColumnIterator& rhs) const {
+    return !(*this == rhs);
+  }
+
+  /**
+   * Returns a pointer to the current value; it is column_width() bytes long.
+   */
+  inline const char* operator*() const {
+    return page_->column_data(column_) +
+        (slot_ - 1) * page_->column_width(column_);
+  }
+
+  /**
+   * Returns the slot of the current value.
+   */
+  SlotId slot_number() const { return slot_; }
+
+ private:
+  /**
+   * Page we're iterating over.
+   */
+  const PaxPage* page_;
+
+  /**
+   * Column we're iterating over.
+   */
+  std::size_t column_;
+
+  /**
+   * Slot of the current value.
+   */
+  SlotId slot_;
+};
+
+}
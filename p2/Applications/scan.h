@@ -0,0 +1,183 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "file_iterator.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Predicate comparing a fixed byte range of a record with a constant.
+ *
+ * This is the simple compiled form of "field op constant" for records with a
+ * fixed binary layout.  Bytes are compared with memcmp, so numbers compare
+ * correctly only if they are stored big-endian (or the operator is EQ / NE).
+ * Records too short to contain the field never match.
+ */
+class FieldPredicate {
+ public:
+  /**
+   * Comparison applied as "field op constant".
+   */
+  enum Operator { EQ, NE, LT, LE, GT, GE };
+
+  /**
+   * Constructs a predicate over the field at the given offset, whose length
+   * is the length of the constant.
+   *
+   * @param offset    Offset of the field within the record.
+   * @param op        Comparison to apply.
+   * @param constant  Bytes to compare the field against.
+   */
+  FieldPredicate(const std::size_t offset, const Operator op,
+                 const std::string& constant)
+      : offset_(offset),
+        op_(op),
+        constant_(constant) {
+  }
+
+  /**
+   * Evaluates the predicate against the given record bytes.
+   *
+   * @param record  Record to test.
+   * @return  True if the record matches.
+   */
+  bool operator()(const RecordView& record) const {
+    if (record.length < offset_ + constant_.length()) {
+      return false;
+    }
+    const int cmp = std::memcmp(record.data + offset_, constant_.data(),
+                                constant_.length());
+    switch (op_) {
+      case EQ: return cmp == 0;
+      case NE: return cmp != 0;
+      case LT: return cmp < 0;
+      case LE: return cmp <= 0;
+      case GT: return cmp > 0;
+      case GE: return cmp >= 0;
+    }
+    return false;
+  }
+
+ private:
+  /**
+   * Offset of the field within the record.
+   */
+  std::size_t offset_;
+
+  /**
+   * Comparison to apply.
+   */
+  Operator op_;
+
+  /**
+   * Bytes to compare the field against.
+   */
+  std::string constant_;
+};
+
+/**
+ * Calls <consumer> with the ID and bytes of every record on <page> for which
+ * <predicate> returns true.  Both are called with a RecordView pointing into
+ * the page, so records are never copied.
+ *
+ * @param page      Page to scan.
+ * @param predicate Callable taking a const RecordView& and returning bool.
+ * @param consumer  Callable taking a const RecordId& and a const RecordView&.
+ */
+template <typename Predicate, typename Consumer>
+void forEachMatch(const Page& page, Predicate& predicate, Consumer& consumer) {
+  for (SlotId slot = page.getNextUsedSlot(Page::INVALID_SLOT);
+       slot != Page::INVALID_SLOT;
+       slot = page.getNextUsedSlot(slot)) {
+    const RecordId record_id = {page.page_number(), slot};
+    const RecordView record = page.getRecordView(record_id);
+    if (predicate(record)) {
+      consumer(record_id, record);
+    }
+  }
+}
+
+/**
+ * Scans every page of <file> through the buffer manager, calling <consumer>
+ * for each record that satisfies <predicate>.  Each page stays pinned only
+ * while it is being scanned, so views passed to the consumer must not be
+ * kept after it returns.
+ *
+ * @param buf_mgr   Buffer manager to read pages through.
+ * @param file      File to scan.
+ * @param predicate Callable taking a const RecordView& and returning bool.
+ * @param consumer  Callable taking a const RecordId& and a const RecordView&.
+ */
+template <typename Predicate, typename Consumer>
+void forEachMatch(BufMgr* buf_mgr, File* file, Predicate predicate,
+                  Consumer consumer) {
+  for (FileIterator iter = file->begin(); iter != file->end(); ++iter) {
+    Page* page;
+    buf_mgr->readPage(file, iter.page_number(), page);
+    try {
+      forEachMatch(*page, predicate, consumer);
+    } catch (...) {
+      buf_mgr->unPinPage(file, iter.page_number(), false);
+      throw;
+    }
+    buf_mgr->unPinPage(file, iter.page_number(), false);
+  }
+}
+
+/**
+ * Collects the IDs of the records that satisfy a predicate.
+ */
+class RecordIdCollector {
+ public:
+  /**
+   * Constructs a collector appending to the given vector.
+   *
+   * @param matches  Vector to append matching record IDs to.
+   */
+  explicit RecordIdCollector(std::vector<RecordId>& matches)
+      : matches_(matches) {
+  }
+
+  void operator()(const RecordId& record_id, const RecordView&) {
+    matches_.push_back(record_id);
+  }
+
+ private:
+  /**
+   * Vector to append matching record IDs to.
+   */
+  std::vector<RecordId>& matches_;
+};
+
+/**
+ * Scans every page of <file> through the buffer manager and appends the IDs
+ * of records that satisfy <predicate> to <matches>.  The predicate is
+ * evaluated against the record bytes inside the pinned page, so records that
+ * do not match are never copied.
+ *
+ * @param buf_mgr   Buffer manager to read pages through.
+ * @param file      File to scan.
+ * @param predicate Callable taking a const RecordView& and returning bool.
+ * @param matches   Vector to append matching record IDs to.
+ */
+template <typename Predicate>
+void scanFile(BufMgr* buf_mgr, File* file, Predicate predicate,
+              std::vector<RecordId>& matches) {
+  forEachMatch(buf_mgr, file, predicate, RecordIdCollector(matches));
+}
+
+}
@@ -0,0 +1,55 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "schema.h"
+
+namespace badgerdb {
+
+std::size_t Schema::addColumn(const std::string& name, const ColumnType type,
+                              const std::size_t width) {
+  Column column;
+  column.name = name;
+  column.type = type;
+  if (type == VARCHAR) {
+    column.width = 0;
+    column.offset = num_varchar_columns_++;
+    columns_.push_back(column);
+    return columns_.size() - 1;
+  }
+  column.offset = record_width_;
+  switch (type) {
+    case INT32: column.width = sizeof(std::int32_t); break;
+    case INT64: column.width = sizeof(std::int64_t); break;
+    case DOUBLE: column.width = sizeof(double); break;
+    case CHAR: column.width = width; break;
+    case VARCHAR: break;
+  }
+  assert(column.width > 0);
+  columns_.push_back(column);
+  record_width_ += column.width;
+  return columns_.size() - 1;
+}
+
+bool Schema::findColumn(const std::string& name, std::size_t& index) const {
+  for (std::size_t i = 0; i < columns_.size(); ++i) {
+    if (columns_[i].name == name) {
+      index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<std::size_t> Schema::column_widths() const {
+  std::vector<std::size_t> widths;
+  for (std::size_t i = 0; i < columns_.size(); ++i) {
+    widths.push_back(columns_[i].width);
+  }
+  return widths;
+}
+
+}
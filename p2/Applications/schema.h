@@ -0,0 +1,394 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "page.h"
+#include "scan.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Type of a column of a Schema.
+ */
+enum ColumnType {
+  INT32,   //!< std::int32_t, 4 bytes.
+  INT64,   //!< std::int64_t, 8 bytes.
+  DOUBLE,  //!< double, 8 bytes.
+  CHAR,    //!< Fixed-width byte string, padded with NUL bytes.
+  VARCHAR  //!< Variable-width byte string; see PackedTupleBuilder.
+};
+
+/**
+ * @brief Description of one column of a Schema.
+ */
+struct Column {
+  /**
+   * Name of the column.
+   */
+  std::string name;
+
+  /**
+   * Type of the column.
+   */
+  ColumnType type;
+
+  /**
+   * Width of the column in bytes, or 0 for a VARCHAR column.
+   */
+  std::size_t width;
+
+  /**
+   * Offset of the column within the fixed-width part of a record, or for a
+   * VARCHAR column, its index among the VARCHAR columns.
+   */
+  std::size_t offset;
+};
+
+/**
+ * @brief Typed columns laid out at fixed offsets in a record.
+ *
+ * Columns are stored back to back in the order they are added, with no
+ * padding, and numbers are stored in machine byte order.  Since every record
+ * of a schema has the same length and layout, a field is read straight from
+ * the record bytes at an offset computed when the schema is built, with no
+ * parsing.  Records of a schema fit PaxPage and FixedPage directly; see
+ * column_widths() and record_width().
+ *
+ * VARCHAR columns have no fixed offset.  Records of a schema with VARCHAR
+ * columns are encoded with PackedTupleBuilder, which stores the fixed-width
+ * columns as above, after a null bitmap, and the VARCHAR columns after them.
+ */
+class Schema {
+ public:
+  /**
+   * Constructs a schema with no columns.
+   */
+  Schema()
+      : record_width_(0),
+        num_varchar_columns_(0) {
+  }
+
+  /**
+   * Appends a column to the schema.
+   *
+   * @param name   Name of the column.
+   * @param type   Type of the column.
+   * @param width  Width of a CHAR column in bytes; ignored for other types.
+   * @return  Index of the new column.
+   */
+  std::size_t addColumn(const std::string& name, const ColumnType type,
+                        const std::size_t width = 0);
+
+  /**
+   * Finds the column with the given name.
+   *
+   * @param name   Name of the column.
+   * @param index  Set to the index of the column if it is found.
+   * @return  False if there is no such column.
+   */
+  bool findColumn(const std::string& name, std::size_t& index) const;
+
+  /**
+   * Returns the column with the given index.
+   */
+  const Column& column(const std::size_t index) const {
+    assert(index < columns_.size());
+    return columns_[index];
+  }
+
+  /**
+   * Returns the number of columns.
+   */
+  std::size_t num_columns() const { return columns_.size(); }
+
+  /**
+   * Returns the length of every record in bytes, not counting VARCHAR
+   * columns.
+   */
+  std::size_t record_width() const { return record_width_; }
+
+  /**
+   * Returns the number of VARCHAR columns.
+   */
+  std::size_t num_varchar_columns() const { return num_varchar_columns_; }
+
+  /**
+   * Returns the width of every column, in order, for use with PaxPage.
+   */
+  std::vector<std::size_t> column_widths() const;
+
+ private:
+  /**
+   * Columns in record order.
+   */
+  std::vector<Column> columns_;
+
+  /**
+   * Length of every record in bytes, not counting VARCHAR columns.
+   */
+  std::size_t record_width_;
+
+  /**
+   * Number of VARCHAR columns.
+   */
+  std::size_t num_varchar_columns_;
+};
+
+/**
+ * @brief Typed read access to the fields of a record, in place.
+ *
+ * A tuple view reads fields directly from record bytes, typically a
+ * RecordView into a pinned page, so it is only valid as long as those bytes
+ * are.  Accessors must be called with the column's type.  Records of a
+ * schema with VARCHAR columns are read with PackedTupleView instead.
+ */
+class TupleView {
+ public:
+  /**
+   * Constructs a view over the given record bytes, which must be
+   * schema.record_width() long.
+   *
+   * @param schema  Schema of the record; must outlive the view.
+   * @param data    First byte of the record.
+   */
+  TupleView(const Schema& schema, const char* data)
+      : schema_(&schema),
+        data_(data) {
+  }
+
+  /**
+   * Returns the INT32 field in the given column.
+   */
+  std::int32_t getInt32(const std::size_t column) const {
+    return load<std::int32_t>(column, INT32);
+  }
+
+  /**
+   * Returns the INT64 field in the given column.
+   */
+  std::int64_t getInt64(const std::size_t column) const {
+    return load<std::int64_t>(column, INT64);
+  }
+
+  /**
+   * Returns the DOUBLE field in the given column.
+   */
+  double getDouble(const std::size_t column) const {
+    return load<double>(column, DOUBLE);
+  }
+
+  /**
+   * Returns a view of the CHAR field in the given column, without its NUL
+   * padding.
+   */
+  RecordView getChar(const std::size_t column) const {
+    const Column& char_column = schema_->column(column);
+    assert(char_column.type == CHAR);
+    const char* field = data_ + char_column.offset;
+    const void* end = std::memchr(field, '\0', char_column.width);
+    const std::size_t length =
+        end == NULL ? char_column.width
+                    : static_cast<std::size_t>(
+                          static_cast<const char*>(end) - field);
+    RecordView view = {field, length};
+    return view;
+  }
+
+ private:
+  /**
+   * Returns the numeric field in the given column.
+   */
+  template <typename T>
+  T load(const std::size_t column, const ColumnType type) const {
+    const Column& numeric_column = schema_->column(column);
+    assert(numeric_column.type == type);
+    T value;
+    std::memcpy(&value, data_ + numeric_column.offset, sizeof(value));
+    return value;
+  }
+
+  /**
+   * Schema of the record.
+   */
+  const Schema* schema_;
+
+  /**
+   * First byte of the record.
+   */
+  const char* data_;
+};
+
+/**
+ * @brief Builds records of a Schema field by field.
+ *
+ * Fields that are not set are zero.  Setters must be called with the
+ * column's type.  Records of a schema with VARCHAR columns are built with
+ * PackedTupleBuilder instead.
+ */
+class TupleBuilder {
+ public:
+  /**
+   * Constructs a builder for records of the given schema.
+   *
+   * @param schema  Schema of the record; must outlive the builder.
+   */
+  explicit TupleBuilder(const Schema& schema)
+      : schema_(&schema),
+        data_(schema.record_width(), '\0') {
+  }
+
+  /**
+   * Sets the INT32 field in the given column.
+   */
+  void setInt32(const std::size_t column, const std::int32_t value) {
+    store(column, INT32, value);
+  }
+
+  /**
+   * Sets the INT64 field in the given column.
+   */
+  void setInt64(const std::size_t column, const std::int64_t value) {
+    store(column, INT64, value);
+  }
+
+  /**
+   * Sets the DOUBLE field in the given column.
+   */
+  void setDouble(const std::size_t column, const double value) {
+    store(column, DOUBLE, value);
+  }
+
+  /**
+   * Sets the CHAR field in the given column.  Values longer than the column
+   * are truncated; shorter ones are padded with NUL bytes.
+   */
+  void setChar(const std::size_t column, const std::string& value) {
+    const Column& char_column = schema_->column(column);
+    assert(char_column.type == CHAR);
+    char* field = &data_[char_column.offset];
+    std::memset(field, '\0', char_column.width);
+    std::memcpy(field, value.data(),
+                std::min(value.length(), char_column.width));
+  }
+
+  /**
+   * Returns the bytes of the record built so far, ready to insert.
+   */
+  const std::string& data() const { return data_; }
+
+ private:
+  /**
+   * Stores a numeric field in the given column.
+   */
+  template <typename T>
+  void store(const std::size_t column, const ColumnType type, const T value) {
+    const Column& numeric_column = schema_->column(column);
+    assert(numeric_column.type == type);
+    std::memcpy(&data_[numeric_column.offset], &value, sizeof(value));
+  }
+
+  /**
+   * Schema of the record.
+   */
+  const Schema* schema_;
+
+  /**
+   * Bytes of the record.
+   */
+  std::string data_;
+};
+
+/**
+ * @brief Predicate comparing a numeric column of a Schema with a constant.
+ *
+ * The typed counterpart of FieldPredicate: the field is loaded from the
+ * record bytes and compared as a number, so it works for negative numbers
+ * and doubles stored in machine byte order.  Records that are not
+ * schema.record_width() long never match.
+ *
+ * @code
+ *   scanFile(buf_mgr, &file,
+ *            ColumnPredicate<std::int32_t>(schema, age, FieldPredicate::GE,
+ *                                          18),
+ *            matches);
+ * @endcode
+ */
+template <typename T>
+class ColumnPredicate {
+ public:
+  /**
+   * Constructs a predicate over the given column, whose type must match T.
+   *
+   * @param schema    Schema of the records.
+   * @param column    Index of the column.
+   * @param op        Comparison to apply.
+   * @param constant  Value to compare the field against.
+   */
+  ColumnPredicate(const Schema& schema, const std::size_t column,
+                  const FieldPredicate::Operator op, const T constant)
+      : offset_(schema.column(column).offset),
+        record_width_(schema.record_width()),
+        op_(op),
+        constant_(constant) {
+    assert(schema.column(column).width == sizeof(T));
+  }
+
+  /**
+   * Evaluates the predicate against the given record bytes.
+   *
+   * @param record  Record to test.
+   * @return  True if the record matches.
+   */
+  bool operator()(const RecordView& record) const {
+    if (record.length != record_width_) {
+      return false;
+    }
+    T value;
+    std::memcpy(&value, record.data + offset_, sizeof(value));
+    switch (op_) {
+      case FieldPredicate::EQ: return value == constant_;
+      case FieldPredicate::NE: return value != constant_;
+      case FieldPredicate::LT: return value < constant_;
+      case FieldPredicate::LE: return value <= constant_;
+      case FieldPredicate::GT: return value > constant_;
+      case FieldPredicate::GE: return value >= constant_;
+    }
+    return false;
+  }
+
+ private:
+  /**
+   * Offset of the column within a record.
+   */
+  std::size_t offset_;
+
+  /**
+   * Length of every record of the schema.
+   */
+  std::size_t record_width_;
+
+  /**
+   * Comparison to apply.
+   */
+  FieldPredicate::Operator op_;
+
+  /**
+   * Value to compare the field against.
+   */
+  T constant_;
+};
+
+}
@@ -0,0 +1,234 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "sorted_page.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "exceptions/insufficient_space_exception.h"
+
+namespace badgerdb {
+
+/**
+ * Compares two byte strings in memcmp order, a shorter string sorting before
+ * any longer string it is a prefix of.
+ */
+static int compareBytes(const char* lhs, const std::size_t lhs_length,
+                        const char* rhs, const std::size_t rhs_length) {
+  const int cmp = std::memcmp(lhs, rhs, std::min(lhs_length, rhs_length));
+  if (cmp != 0) {
+    return cmp;
+  }
+  return lhs_length < rhs_length ? -1 : (lhs_length > rhs_length ? 1 : 0);
+}
+
+void SortedPage::initialize() {
+  const PageId page_number = page_->page_number();
+  const PageId next_page_number = page_->next_page_number();
+  page_->initialize();
+  page_->set_page_number(page_number);
+  page_->set_next_page_number(next_page_number);
+  // Leave no free space for the slotted page API.
+  page_->header_.free_space_lower_bound = page_->data_size();
+  page_->header_.free_space_upper_bound = page_->data_size();
+  page_->header_.format = PAGE_FORMAT_SORTED;
+  format("");
+}
+
+std::size_t SortedPage::insertRecord(const std::string& record_data) {
+  const RecordView record = {record_data.data(), record_data.length()};
+  const std::string key = key_of_(record);
+
+  // The prefix shrinks to what the new key shares with it, which lengthens
+  // the stored suffix of every record already on the page.
+  const SortedHeader& sorted_header = header();
+  std::size_t prefix_length = key.length();
+  if (sorted_header.num_records > 0) {
+    const char* prefix = &page_->data_[sorted_header.prefix_offset];
+    prefix_length = 0;
+    while (prefix_length < sorted_header.prefix_length &&
+           prefix_length < key.length() &&
+           prefix[prefix_length] == key[prefix_length]) {
+      ++prefix_length;
+    }
+  }
+  const std::size_t needed =
+      key.length() - prefix_length + record.length + sizeof(SortedSlot);
+
+  if (sorted_header.num_records == 0) {
+    if (needed + prefix_length > page_->data_size() - sizeof(SortedHeader)) {
+      throw InsufficientSpaceException(
+          page_->page_number(), needed + prefix_length,
+          page_->data_size() - sizeof(SortedHeader));
+    }
+    format(key);
+  } else {
+    const std::size_t shrink = sorted_header.prefix_length - prefix_length;
+    const std::size_t growth = shrink * (sorted_header.num_records - 1);
+    const std::size_t available = getFreeSpace();
+    if (needed + growth > available) {
+      throw InsufficientSpaceException(
+          page_->page_number(), needed,
+          available > growth ? available - growth : 0);
+    }
+    if (shrink > 0 || needed > contiguousFreeSpace()) {
+      rebuild(prefix_length);
+    }
+  }
+
+  const std::size_t position = upperBound(key);
+  insertAt(position, key, record);
+  return position;
+}
+
+void SortedPage::deleteRecord(const std::size_t position) {
+  assert(position < num_records());
+  SortedHeader& sorted_header = header();
+  const SortedSlot& deleted = *slot(position);
+  const std::size_t entry_length =
+      deleted.suffix_length + deleted.record_length;
+  if (deleted.offset == sorted_header.heap_begin) {
+    sorted_header.heap_begin += entry_length;
+  } else {
+    sorted_header.garbage += entry_length;
+  }
+  const std::size_t following = sorted_header.num_records - position - 1;
+  std::memmove(slot(position), slot(position + 1),
+               following * sizeof(SortedSlot));
+  --sorted_header.num_records;
+}
+
+RecordView SortedPage::getRecord(const std::size_t position) const {
+  assert(position < num_records());
+  const SortedSlot& record_slot = slot(position);
+  RecordView view = {
+      &page_->data_[record_slot.offset + record_slot.suffix_length],
+      record_slot.record_length};
+  return view;
+}
+
+std::string SortedPage::getKey(const std::size_t position) const {
+  assert(position < num_records());
+  const SortedSlot& record_slot = slot(position);
+  std::string key(&page_->data_[header().prefix_offset],
+                  header().prefix_length);
+  key.append(&page_->data_[record_slot.offset], record_slot.suffix_length);
+  return key;
+}
+
+std::size_t SortedPage::lowerBound(const std::string& key) const {
+  std::size_t lo = 0;
+  std::size_t hi = num_records();
+  while (lo < hi) {
+    const std::size_t mid = lo + (hi - lo) / 2;
+    if (compareKey(mid, key) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+std::size_t SortedPage::upperBound(const std::string& key) const {
+  std::size_t lo = 0;
+  std::size_t hi = num_records();
+  while (lo < hi) {
+    const std::size_t mid = lo + (hi - lo) / 2;
+    if (compareKey(mid, key) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+bool SortedPage::find(const std::string& key, std::size_t& position) const {
+  const std::size_t found = lowerBound(key);
+  if (found == num_records() || compareKey(found, key) != 0) {
+    return false;
+  }
+  position = found;
+  return true;
+}
+
+int SortedPage::compareKey(const std::size_t position,
+                           const std::string& key) const {
+  const SortedHeader& sorted_header = header();
+  const std::size_t prefix_length = sorted_header.prefix_length;
+  const std::size_t head = std::min(prefix_length, key.length());
+  const int cmp = std::memcmp(&page_->data_[sorted_header.prefix_offset],
+                              key.data(), head);
+  if (cmp != 0) {
+    return cmp;
+  }
+  if (key.length() < prefix_length) {
+    // <key> is a proper prefix of every key on the page.
+    return 1;
+  }
+  const SortedSlot& record_slot = slot(position);
+  return compareBytes(&page_->data_[record_slot.offset],
+                      record_slot.suffix_length, key.data() + prefix_length,
+                      key.length() - prefix_length);
+}
+
+void SortedPage::format(const std::string& prefix) {
+  SortedHeader& sorted_header = header();
+  sorted_header.num_records = 0;
+  sorted_header.garbage = 0;
+  sorted_header.heap_begin = page_->data_size() - prefix.length();
+  sorted_header.prefix_offset = sorted_header.heap_begin;
+  sorted_header.prefix_length = prefix.length();
+  std::memcpy(&page_->data_[sorted_header.prefix_offset], prefix.data(),
+              prefix.length());
+}
+
+void SortedPage::rebuild(const std::size_t prefix_length) {
+  assert(prefix_length <= header().prefix_length);
+  std::vector<std::string> keys;
+  std::vector<std::string> records;
+  keys.reserve(num_records());
+  records.reserve(num_records());
+  for (std::size_t position = 0; position < num_records(); ++position) {
+    keys.push_back(getKey(position));
+    records.push_back(getRecord(position).toString());
+  }
+
+  format(keys.empty() ? std::string() : keys[0].substr(0, prefix_length));
+  for (std::size_t position = 0; position < keys.size(); ++position) {
+    const RecordView record = {records[position].data(),
+                               records[position].length()};
+    insertAt(position, keys[position], record);
+  }
+}
+
+void SortedPage::insertAt(const std::size_t position, const std::string& key,
+                          const RecordView& record) {
+  SortedHeader& sorted_header = header();
+  const std::size_t suffix_length = key.length() - sorted_header.prefix_length;
+  assert(suffix_length + record.length + sizeof(SortedSlot) <=
+         contiguousFreeSpace());
+
+  sorted_header.heap_begin -= suffix_length + record.length;
+  std::memcpy(&page_->data_[sorted_header.heap_begin],
+              key.data() + sorted_header.prefix_length, suffix_length);
+  std::memcpy(&page_->data_[sorted_header.heap_begin + suffix_length],
+              record.data, record.length);
+
+  std::memmove(slot(position + 1), slot(position),
+               (sorted_header.num_records - position) * sizeof(SortedSlot));
+  SortedSlot* record_slot = slot(position);
+  record_slot->offset = sorted_header.heap_begin;
+  record_slot->suffix_length = suffix_length;
+  record_slot->record_length = record.length;
+  ++sorted_header.num_records;
+}
+
+}
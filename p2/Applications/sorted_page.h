@@ -0,0 +1,312 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <functional>
+#include <string>
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Metadata stored at the start of the data area of a sorted page.
+ */
+struct SortedHeader {
+  /**
+   * Number of records on the page.
+   */
+  PageOffset num_records;
+
+  /**
+   * Offset of the first byte of the entry heap, which grows downwards from
+   * the end of the data area.
+   */
+  PageOffset heap_begin;
+
+  /**
+   * Bytes in the entry heap left behind by deleted records.
+   */
+  PageOffset garbage;
+
+  /**
+   * Offset of the key prefix shared by every record on the page.
+   */
+  PageOffset prefix_offset;
+
+  /**
+   * Length of the shared key prefix.
+   */
+  PageOffset prefix_length;
+};
+
+/**
+ * @brief Slot of a sorted page, locating one record and its key.
+ */
+struct SortedSlot {
+  /**
+   * Offset of the entry: the key suffix followed by the record.
+   */
+  PageOffset offset;
+
+  /**
+   * Length of the key with the shared prefix removed.
+   */
+  PageOffset suffix_length;
+
+  /**
+   * Length of the record.
+   */
+  PageOffset record_length;
+};
+
+/**
+ * @brief View which keeps the records of a Page ordered by key.
+ *
+ * Keys are produced from records by a user-supplied extractor and compared
+ * as byte strings (memcmp order), so numbers must be stored big-endian to
+ * sort numerically.  The slot array follows the SortedHeader and is kept in
+ * key order, so records are addressed by position (0 to num_records() - 1)
+ * and looked up by binary search.  Positions are not stable: inserting or
+ * deleting a record shifts the positions of the records after it.
+ *
+ * Each key is stored next to its record with the prefix shared by every key
+ * on the page stored only once.  The prefix shrinks as keys that do not share
+ * it are inserted; the page is rewritten then, and also when a record only
+ * fits after the space of deleted records is reclaimed.
+ *
+ * As with PAX pages, the slotted page header describes an empty page with no
+ * free space, so file scans see no records on a sorted page.  The header
+ * records PAGE_FORMAT_SORTED, so reading the page as any other format, or a
+ * page of another format as a sorted page, throws PageFormatException.
+ *
+ * @code
+ *   SortedPage sorted(page, [](const RecordView& r) {
+ *     return std::string(r.data, 8);
+ *   });
+ *   for (std::size_t pos = sorted.lowerBound(lo);
+ *        pos < sorted.num_records() && sorted.getKey(pos) < hi; ++pos) {
+ *     use(sorted.getRecord(pos));
+ *   }
+ * @endcode
+ *
+ * @warning This class is not threadsafe.
+ */
+class SortedPage {
+ public:
+  /**
+   * Function returning the key of a record.
+   */
+  typedef std::function<std::string(const RecordView&)> KeyExtractor;
+
+  /**
+   * Constructs a sorted view over the given page.  The page must outlive the
+   * view (typically it is pinned in the buffer pool), and must be formatted
+   * with initialize() before records are inserted.
+   *
+   * @param page    Page to view.
+   * @param key_of  Extractor returning the key of a record.
+   */
+  SortedPage(Page* page, const KeyExtractor& key_of)
+      : page_(page),
+        key_of_(key_of) {
+    assert(page_ != NULL);
+  }
+
+  /**
+   * Formats the viewed page as an empty sorted page.
+   */
+  void initialize();
+
+  /**
+   * Inserts a record at the position given by its key.  A record whose key
+   * equals existing keys goes after them.
+   *
+   * @param record_data  Bytes that compose the record.
+   * @return  Position of the newly inserted record.
+   * @throws  InsufficientSpaceException  If the record does not fit, even
+   *                                      after the page is rewritten.
+   */
+  std::size_t insertRecord(const std::string& record_data);
+
+  /**
+   * Deletes the record at the given position.
+   *
+   * @param position  Position of the record to delete.
+   */
+  void deleteRecord(const std::size_t position);
+
+  /**
+   * Returns a view of the record at the given position.
+   *
+   * @param position  Position of the record.
+   * @return  View of the record.
+   */
+  RecordView getRecord(const std::size_t position) const;
+
+  /**
+   * Returns the key of the record at the given position, with the shared
+   * prefix restored.
+   *
+   * @param position  Position of the record.
+   * @return  Key of the record.
+   */
+  std::string getKey(const std::size_t position) const;
+
+  /**
+   * Returns the position of the first record whose key is not less than the
+   * given key, or num_records() if there is none.
+   *
+   * @param key  Key to search for.
+   * @return  Position of the first record with a key >= <key>.
+   */
+  std::size_t lowerBound(const std::string& key) const;
+
+  /**
+   * Returns the position of the first record whose key is greater than the
+   * given key, or num_records() if there is none.
+   *
+   * @param key  Key to search for.
+   * @return  Position of the first record with a key > <key>.
+   */
+  std::size_t upperBound(const std::string& key) const;
+
+  /**
+   * Finds the first record with the given key.
+   *
+   * @param key       Key to search for.
+   * @param position  Set to the position of the record if it is found.
+   * @return  False if no record has the key.
+   */
+  bool find(const std::string& key, std::size_t& position) const;
+
+  /**
+   * Calls <consumer> with a view of every record whose key is in [lo, hi),
+   * in key order.
+   *
+   * @param lo        Smallest key in the range.
+   * @param hi        Key just past the range.
+   * @param consumer  Callable taking a const RecordView&.
+   */
+  template <typename Consumer>
+  void forEachInRange(const std::string& lo, const std::string& hi,
+                      Consumer& consumer) const {
+    const std::size_t end = lowerBound(hi);
+    for (std::size_t position = lowerBound(lo); position < end; ++position) {
+      consumer(getRecord(position));
+    }
+  }
+
+  /**
+   * Returns the number of records on the page.
+   */
+  std::size_t num_records() const { return header().num_records; }
+
+  /**
+   * Returns the length of the key prefix shared by every record.
+   */
+  std::size_t prefix_length() const { return header().prefix_length; }
+
+  /**
+   * Returns the number of bytes available for new entries and slots,
+   * counting the space of deleted records.
+   */
+  std::size_t getFreeSpace() const {
+    return contiguousFreeSpace() + header().garbage;
+  }
+
+ private:
+  /**
+   * Returns the header stored at the start of the data area.
+   */
+  SortedHeader& header() {
+    page_->checkFormat(PAGE_FORMAT_SORTED);
+    return *reinterpret_cast<SortedHeader*>(&page_->data_[0]);
+  }
+
+  /**
+   * Returns the header stored at the start of the data area.
+   */
+  const SortedHeader& header() const {
+    page_->checkFormat(PAGE_FORMAT_SORTED);
+    return *reinterpret_cast<const SortedHeader*>(&page_->data_[0]);
+  }
+
+  /**
+   * Returns the slot at the given position.
+   */
+  SortedSlot* slot(const std::size_t position) {
+    return reinterpret_cast<SortedSlot*>(
+        &page_->data_[sizeof(SortedHeader) + position * sizeof(SortedSlot)]);
+  }
+
+  /**
+   * Returns the slot at the given position.
+   */
+  const SortedSlot& slot(const std::size_t position) const {
+    return *reinterpret_cast<const SortedSlot*>(
+        &page_->data_[sizeof(SortedHeader) + position * sizeof(SortedSlot)]);
+  }
+
+  /**
+   * Returns the number of bytes between the slot array and the entry heap.
+   */
+  std::size_t contiguousFreeSpace() const {
+    return header().heap_begin - sizeof(SortedHeader) -
+        num_records() * sizeof(SortedSlot);
+  }
+
+  /**
+   * Compares the key of the record at the given position with <key>.
+   *
+   * @return  Negative, zero or positive as the record's key is less than,
+   *          equal to or greater than <key>.
+   */
+  int compareKey(const std::size_t position, const std::string& key) const;
+
+  /**
+   * Clears the page and sets the key prefix shared by every record.
+   *
+   * @param prefix  Key prefix.
+   */
+  void format(const std::string& prefix);
+
+  /**
+   * Rewrites the page with a shorter key prefix, reclaiming the space of
+   * deleted records.
+   *
+   * @param prefix_length  New prefix length; at most the current one.
+   */
+  void rebuild(const std::size_t prefix_length);
+
+  /**
+   * Writes a record into the entry heap and its slot at the given position.
+   * The key must start with the shared prefix and the entry must fit in the
+   * contiguous free space.
+   *
+   * @param position  Position of the new record.
+   * @param key       Key of the record.
+   * @param record    Record to write.
+   */
+  void insertAt(const std::size_t position, const std::string& key,
+                const RecordView& record);
+
+  /**
+   * Page being viewed.
+   */
+  Page* page_;
+
+  /**
+   * Extractor returning the key of a record.
+   */
+  KeyExtractor key_of_;
+};
+
+}
@@ -0,0 +1,229 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "task_scheduler.h"
+
+#include <algorithm>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Number of times an idle worker looks for a task to steal before it sleeps.
+ */
+const int STEAL_ROUNDS = 64;
+
+/**
+ * Scheduler and index of the worker running on this thread, if any.
+ */
+struct CurrentWorker {
+  const TaskScheduler* scheduler;
+  std::uint32_t index;
+};
+
+thread_local CurrentWorker current_worker = {nullptr, 0};
+
+}
+
+TaskScheduler::TaskScheduler(std::uint32_t workers)
+    : queued_(0), next_worker_(0), sleepers_(0), stopping_(false) {
+  if (workers == 0) {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (std::uint32_t i = 0; i < workers; ++i) {
+    workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+  }
+  // Every deque must exist before any worker starts stealing.
+  for (std::uint32_t i = 0; i < workers; ++i) {
+    workers_[i]->thread = std::thread(&TaskScheduler::workerLoop, this, i);
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  stopping_.store(true);
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    idle_.notify_all();
+  }
+  for (std::size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->thread.join();
+  }
+}
+
+void TaskScheduler::spawn(TaskGroup& group, std::function<void()> task) {
+  group.pending_.fetch_add(1, std::memory_order_relaxed);
+  const std::uint32_t self = currentWorker();
+  Worker& worker = *workers_[self < workerCount()
+                                 ? self
+                                 : next_worker_.fetch_add(1) % workerCount()];
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    Task queued = {std::move(task), &group};
+    worker.tasks.push_back(std::move(queued));
+  }
+  queued_.fetch_add(1);
+  if (sleepers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    idle_.notify_one();
+  }
+}
+
+void TaskScheduler::wait(TaskGroup& group) {
+  const std::uint32_t self = currentWorker();
+  while (!group.done()) {
+    Task task;
+    if (findTask(self, task)) {
+      runTask(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    sleepers_.fetch_add(1);
+    idle_.wait(lock, [this, &group]() {
+      return queued_.load() > 0 || group.done();
+    });
+    sleepers_.fetch_sub(1);
+  }
+
+  std::lock_guard<std::mutex> lock(group.error_mutex_);
+  if (group.error_) {
+    std::exception_ptr error = group.error_;
+    group.error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+bool TaskScheduler::findTask(const std::uint32_t self, Task& task) {
+  if (queued_.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  const std::uint32_t count = workerCount();
+  if (self < count) {
+    Worker& own = *workers_[self];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  // Steal the oldest task of the next worker that has one.
+  for (std::uint32_t k = 1; k <= count; ++k) {
+    const std::uint32_t victim = (self + k) % count;
+    if (victim == self) {
+      continue;
+    }
+    Worker& other = *workers_[victim];
+    std::lock_guard<std::mutex> lock(other.mutex);
+    if (!other.tasks.empty()) {
+      task = std::move(other.tasks.front());
+      other.tasks.pop_front();
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void TaskScheduler::runTask(Task& task) {
+  TaskGroup* group = task.group;
+  try {
+    task.body();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(group->error_mutex_);
+    if (!group->error_) {
+      group->error_ = std::current_exception();
+    }
+  }
+  // Drop what the task captured before its waiter may return.
+  task.body = nullptr;
+  if (group->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+      sleepers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    idle_.notify_all();
+  }
+}
+
+void TaskScheduler::workerLoop(const std::uint32_t self) {
+  current_worker.scheduler = this;
+  current_worker.index = self;
+  int rounds = 0;
+  while (true) {
+    Task task;
+    if (findTask(self, task)) {
+      runTask(task);
+      rounds = 0;
+      continue;
+    }
+    if (stopping_.load()) {
+      return;
+    }
+    if (rounds < STEAL_ROUNDS) {
+      ++rounds;
+      std::this_thread::yield();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    sleepers_.fetch_add(1);
+    idle_.wait(lock, [this]() {
+      return queued_.load() > 0 || stopping_.load();
+    });
+    sleepers_.fetch_sub(1);
+    rounds = 0;
+  }
+}
+
+std::uint32_t TaskScheduler::currentWorker() const {
+  return current_worker.scheduler == this ? current_worker.index
+                                          : workerCount();
+}
+
+void scanPages(TaskScheduler& scheduler, BufMgr* buf_mgr, File* file,
+               const std::vector<PageId>& pages,
+               const std::function<void(PageId, const Page&)>& visit,
+               const std::uint32_t pages_per_task) {
+  const std::size_t step = std::max(1u, pages_per_task);
+  TaskGroup group;
+  for (std::size_t i = 0; i < pages.size(); i += step) {
+    const std::size_t end = std::min(pages.size(), i + step);
+    scheduler.spawn(group, [buf_mgr, file, &pages, &visit, i, end]() {
+      for (std::size_t j = i; j < end; ++j) {
+        PageGuard guard = buf_mgr->readPage(file, pages[j], LATCH_SHARED);
+        visit(pages[j], *guard);
+      }
+    });
+  }
+  scheduler.wait(group);
+}
+
+void prefetchPages(TaskScheduler& scheduler, TaskGroup& group,
+                   BufMgr* buf_mgr, File* file,
+                   const std::vector<PageId>& pages) {
+  const std::size_t step = 16;
+  for (std::size_t i = 0; i < pages.size(); i += step) {
+    const std::vector<PageId> chunk(
+        pages.begin() + i, pages.begin() + std::min(pages.size(), i + step));
+    scheduler.spawn(group, [buf_mgr, file, chunk]() {
+      for (std::size_t j = 0; j < chunk.size(); ++j) {
+        buf_mgr->readPage(file, chunk[j]);
+      }
+    });
+  }
+}
+
+void flushFiles(TaskScheduler& scheduler, BufMgr* buf_mgr,
+                const std::vector<File*>& files) {
+  TaskGroup group;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    File* file = files[i];
+    scheduler.spawn(group, [buf_mgr, file]() { buf_mgr->flushFile(file); });
+  }
+  scheduler.wait(group);
+}
+
+}
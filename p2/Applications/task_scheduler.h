@@ -0,0 +1,232 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Set of tasks that can be waited for together.
+ *
+ * A group counts the tasks spawned into it that have not finished yet, and
+ * keeps the first exception one of them threw so that the waiter sees it.
+ * Tasks may spawn more tasks into their own group.
+ */
+class TaskGroup {
+ public:
+  TaskGroup() : pending_(0) {}
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  /**
+   * Returns true once every task spawned into the group has finished.
+   */
+  bool done() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+ private:
+  friend class TaskScheduler;
+
+  /**
+   * Number of tasks spawned into the group that have not finished.
+   */
+  std::atomic<std::uint32_t> pending_;
+
+  /**
+   * First exception thrown by a task of the group, rethrown by wait().
+   */
+  std::exception_ptr error_;
+
+  /**
+   * Lock protecting error_.
+   */
+  std::mutex error_mutex_;
+};
+
+/**
+ * @brief Work-stealing pool of worker threads running storage tasks.
+ *
+ * Each worker owns a deque of tasks.  A task spawned on a worker goes on the
+ * back of that worker's deque and the worker takes its own tasks from the
+ * back, so recently spawned and still cache-hot work runs first.  A worker
+ * whose deque is empty steals from the front of another's, taking the oldest
+ * and usually largest piece of work, and sleeps once there is nothing left to
+ * steal.  Tasks spawned by other threads are handed to the workers in turn.
+ *
+ * A thread waiting for a group runs queued tasks until the group is done, so
+ * tasks can wait for tasks they spawned without tying up a worker.
+ *
+ * Tasks read and write pages through a BufMgr, which serializes the File
+ * calls they cause; scans of cached pages scale with the workers, while
+ * faults wait for one another's I/O.
+ */
+class TaskScheduler {
+ public:
+  /**
+   * Starts the workers.
+   *
+   * @param workers  Number of worker threads; 0 starts one per hardware thread.
+   */
+  explicit TaskScheduler(std::uint32_t workers = 0);
+
+  TaskScheduler(const TaskScheduler&) = delete;
+  TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+  /**
+   * Runs every task still queued and stops the workers.
+   */
+  ~TaskScheduler();
+
+  /**
+   * Queues a task in a group.
+   *
+   * @param group  Group the task is counted in until it finishes.
+   * @param task   Work to run on some worker.
+   */
+  void spawn(TaskGroup& group, std::function<void()> task);
+
+  /**
+   * Runs queued tasks until every task of the group has finished.
+   *
+   * @param group  Group to wait for.
+   * @throws  The first exception thrown by a task of the group, if any.
+   */
+  void wait(TaskGroup& group);
+
+  /**
+   * Returns the number of worker threads.
+   */
+  std::uint32_t workerCount() const {
+    return static_cast<std::uint32_t>(workers_.size());
+  }
+
+ private:
+  struct Task {
+    std::function<void()> body;
+    TaskGroup* group;
+  };
+
+  struct Worker {
+    std::deque<Task> tasks;
+    std::mutex mutex;
+    std::thread thread;
+  };
+
+  /**
+   * Takes a task for the worker at <self>: from the back of its own deque,
+   * else from the front of another worker's.  Threads that are not workers
+   * pass workerCount() and only steal.
+   *
+   * @return  False if every deque was empty.
+   */
+  bool findTask(const std::uint32_t self, Task& task);
+
+  /**
+   * Runs a task and counts it finished in its group.
+   */
+  void runTask(Task& task);
+
+  /**
+   * Body of the worker thread at <self>.
+   */
+  void workerLoop(const std::uint32_t self);
+
+  /**
+   * Returns the index of the calling thread if it is a worker of this
+   * scheduler, else workerCount().
+   */
+  std::uint32_t currentWorker() const;
+
+  std::vector<std::unique_ptr<Worker> > workers_;
+
+  /**
+   * Number of tasks sitting in deques, read by threads deciding to sleep.
+   */
+  std::atomic<std::uint32_t> queued_;
+
+  /**
+   * Worker the next task spawned from outside the pool goes to.
+   */
+  std::atomic<std::uint32_t> next_worker_;
+
+  /**
+   * Number of threads sleeping on idle_, so that spawning a task or
+   * finishing a group only takes idle_mutex_ when someone needs waking.
+   */
+  std::atomic<std::uint32_t> sleepers_;
+
+  /**
+   * Set by the destructor to let idle workers exit.
+   */
+  std::atomic<bool> stopping_;
+
+  /**
+   * Idle workers and waiters sleep on idle_ under idle_mutex_ until a task is
+   * queued or a group finishes.
+   */
+  std::mutex idle_mutex_;
+  std::condition_variable idle_;
+};
+
+/**
+ * Reads pages of a file in parallel through the buffer manager, under shared
+ * latches, and passes each to <visit>.  Pages are split into tasks of
+ * <pages_per_task> pages; <visit> is called concurrently.
+ *
+ * @param scheduler       Scheduler running the scan.
+ * @param buf_mgr         Buffer manager to read the pages through.
+ * @param file            File holding the pages.
+ * @param pages           Numbers of the pages to read.
+ * @param visit           Called with each page number and its page.
+ * @param pages_per_task  Number of pages read by one task.
+ * @throws  The first exception thrown by a read or by <visit>.
+ */
+void scanPages(TaskScheduler& scheduler, BufMgr* buf_mgr, File* file,
+               const std::vector<PageId>& pages,
+               const std::function<void(PageId, const Page&)>& visit,
+               const std::uint32_t pages_per_task = 16);
+
+/**
+ * Queues tasks reading pages of a file into the buffer pool and returns at
+ * once.  Wait for <group> before relying on the pages being cached.
+ *
+ * @param scheduler  Scheduler running the reads.
+ * @param group      Group the reads are spawned into.
+ * @param buf_mgr    Buffer manager to read the pages into.
+ * @param file       File holding the pages.
+ * @param pages      Numbers of the pages to read.
+ */
+void prefetchPages(TaskScheduler& scheduler, TaskGroup& group,
+                   BufMgr* buf_mgr, File* file,
+                   const std::vector<PageId>& pages);
+
+/**
+ * Flushes several files from the buffer pool, one task per file.
+ *
+ * @param scheduler  Scheduler running the flushes.
+ * @param buf_mgr    Buffer manager to flush.
+ * @param files      Files to flush.
+ * @throws  The first exception thrown by BufMgr::flushFile().
+ */
+void flushFiles(TaskScheduler& scheduler, BufMgr* buf_mgr,
+                const std::vector<File*>& files);
+
+}
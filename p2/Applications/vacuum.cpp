@@ -0,0 +1,100 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "vacuum.h"
+
+#include <limits>
+#include <string>
+
+#include "file_iterator.h"
+
+namespace badgerdb {
+
+Vacuum::Vacuum(BufMgr* buf_mgr, File* file, const Relocator& relocated)
+    : buf_mgr_(buf_mgr),
+      file_(file),
+      relocated_(relocated),
+      front_(0),
+      back_(0) {
+  for (FileIterator iter = file_->begin(); iter != file_->end(); ++iter) {
+    pages_.push_back(iter.page_number());
+  }
+  if (!pages_.empty()) {
+    back_ = pages_.size() - 1;
+  }
+  stats_.pages_before = pages_.size();
+  stats_.pages_after = pages_.size();
+  stats_.records_moved = 0;
+}
+
+bool Vacuum::step(std::size_t page_budget) {
+  while (!done() && page_budget > 0) {
+    const PageId source_number = pages_[back_];
+    Page* source;
+    buf_mgr_->readPage(file_, source_number, source);
+    --page_budget;
+
+    // Move records to the front page until the source is empty, the budget
+    // runs out, or the cursors meet.
+    Page* target = NULL;
+    bool source_dirty = false;
+    bool target_dirty = false;
+    SlotId slot = source->getNextUsedSlot(Page::INVALID_SLOT);
+    while (slot != Page::INVALID_SLOT && front_ < back_) {
+      if (target == NULL) {
+        if (page_budget == 0) {
+          break;
+        }
+        buf_mgr_->readPage(file_, pages_[front_], target);
+        --page_budget;
+        target_dirty = false;
+      }
+      const RecordId from = {source_number, slot};
+      const std::string record_data = source->getRecordView(from).toString();
+      if (!target->hasSpaceForRecord(record_data)) {
+        buf_mgr_->unPinPage(file_, pages_[front_], target_dirty);
+        target = NULL;
+        ++front_;
+        continue;
+      }
+      const RecordId to = target->insertRecord(record_data);
+      target_dirty = true;
+      const SlotId next_slot = source->getNextUsedSlot(slot);
+      source->deleteRecord(from);
+      source_dirty = true;
+      ++stats_.records_moved;
+      if (relocated_) {
+        relocated_(from, to);
+      }
+      slot = next_slot;
+    }
+    if (target != NULL) {
+      buf_mgr_->unPinPage(file_, pages_[front_], target_dirty);
+    }
+
+    // Only a slotted page with no records has all of its data area free;
+    // other page formats leave none.
+    const bool empty = source->getFreeSpace() == source->data_size();
+    buf_mgr_->unPinPage(file_, source_number, source_dirty);
+    if (slot != Page::INVALID_SLOT) {
+      break;
+    }
+    if (empty) {
+      buf_mgr_->disposePage(file_, source_number);
+      --stats_.pages_after;
+    }
+    --back_;
+  }
+  return done();
+}
+
+void Vacuum::run() {
+  while (!step(std::numeric_limits<std::size_t>::max())) {
+  }
+}
+
+}
@@ -0,0 +1,142 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Page and record counts reported by a Vacuum.
+ */
+struct VacuumStats {
+  /**
+   * Number of pages in the file when the vacuum started.
+   */
+  std::size_t pages_before;
+
+  /**
+   * Number of pages in the file now.
+   */
+  std::size_t pages_after;
+
+  /**
+   * Number of records moved to another page.
+   */
+  std::size_t records_moved;
+};
+
+/**
+ * @brief Online compaction of the slotted pages of a file.
+ *
+ * A vacuum packs the records of a file into as few pages as possible.  It
+ * keeps one cursor at the front of the file and one at the back, and moves
+ * the records of the back page into the free space and free slots of the
+ * front pages.  Every back page it empties is disposed of, which returns it
+ * to the file's free list.  Pages without slotted records, such as PAX or
+ * overflow pages, are neither filled nor disposed of.
+ *
+ * All page accesses go through the buffer manager and pages are pinned only
+ * while records are moved, so the file stays usable between steps.  Moving a
+ * record changes its RecordId; the relocation callback is told about every
+ * move so that references to the record can be updated.  A HeapFile over the
+ * file caches free space per page and must be reopened after a vacuum.
+ *
+ * @code
+ *   Vacuum vacuum(buf_mgr, &file, onRelocate);
+ *   while (!vacuum.step(16)) {
+ *     serveOtherRequests();
+ *   }
+ * @endcode
+ *
+ * @warning This class is not threadsafe.
+ */
+class Vacuum {
+ public:
+  /**
+   * Function called with the old and new ID of every moved record.
+   */
+  typedef std::function<void(const RecordId&, const RecordId&)> Relocator;
+
+  /**
+   * Starts a vacuum of the given file.  Walks the page list of the file once
+   * to find its pages.
+   *
+   * @param buf_mgr    Buffer manager to access pages through.
+   * @param file       File to vacuum.
+   * @param relocated  Function called for every moved record; may be empty.
+   */
+  Vacuum(BufMgr* buf_mgr, File* file, const Relocator& relocated);
+
+  /**
+   * Continues the vacuum, reading at most <page_budget> pages.
+   *
+   * @param page_budget  Maximum number of pages to read in this step.
+   * @return  True if the vacuum is finished.
+   */
+  bool step(std::size_t page_budget);
+
+  /**
+   * Runs the vacuum to completion.
+   */
+  void run();
+
+  /**
+   * Returns true if the vacuum is finished.
+   */
+  bool done() const { return front_ >= back_; }
+
+  /**
+   * Returns page and record counts so far.
+   */
+  const VacuumStats& stats() const { return stats_; }
+
+ private:
+  /**
+   * Buffer manager to access pages through.
+   */
+  BufMgr* buf_mgr_;
+
+  /**
+   * File being vacuumed.
+   */
+  File* file_;
+
+  /**
+   * Function called for every moved record.
+   */
+  Relocator relocated_;
+
+  /**
+   * Numbers of the pages of the file, in page list order.
+   */
+  std::vector<PageId> pages_;
+
+  /**
+   * Index in pages_ of the page records are moved to.
+   */
+  std::size_t front_;
+
+  /**
+   * Index in pages_ of the page records are moved from.
+   */
+  std::size_t back_;
+
+  /**
+   * Page and record counts so far.
+   */
+  VacuumStats stats_;
+};
+
+}